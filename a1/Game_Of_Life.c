@@ -1,139 +1,315 @@
-/****************************************************** 
+/******************************************************
  ************* Conway's game of life ******************
  ******************************************************
 
- Usage: ./exec ArraySize TimeSteps                   
+ Usage: ./exec [options] ArraySize TimeSteps
 
- Compile with -DOUTPUT to print output in output.gif 
- (You will need ImageMagick for that - Install with
- sudo apt-get install imagemagick)
- WARNING: Do not print output for large array sizes!
- or multiple time steps!
+ Options:
+   -e engine   dense  : one int per cell, int ** rows (default)
+               packed : 64 cells per uint64_t, bit-sliced rule
+               omp    : dense kernel, one first-touched row band
+                        per OpenMP thread (OMP_NUM_THREADS)
+               tiled  : temporal blocking, B x B tiles advanced
+                        D generations per visit (OpenMP over tiles)
+               sparse : only recompute B x B tiles that changed in
+                        the last generation, and their neighbours
+               hashlife : memoized quadtree, jumps 2^k generations
+                        at a time (one jump per set bit of TimeSteps)
+               flat   : dense kernel on one aligned block of byte
+                        cells with cache-line padded rows (OpenMP)
+               simd   : flat grid with explicit AVX-512/AVX2/SSE2
+                        row kernels picked by CPUID (LIFE_ISA=...
+                        forces one)
+   -r rule     life-like rule in B/S notation, e.g. B36/S23, or
+               conway, highlife, daynight, seeds (default B3/S23;
+               omp, tiled and sparse only run B3/S23)
+   -t          torus: wrap around at the edges instead of
+               keeping a dead frame (dense, packed, flat, simd)
+   -b B        tile size (default 128)
+   -d D        generations per tile visit (default 8)
+   -m MB       hashlife node cache limit before GC (default 1024)
+   -v          per-step engine output (active tiles for sparse)
+   -p          pin threads to cores (cpu list from MT_CONF)
+   -c          check the final board against the dense engine
+   -o file     stream snapshots of the board to file
+   -k K        only snapshot every K-th generation (default 1)
+   -s seed     seed of the random initial board (default 1);
+               the board is the same for any thread count
+   -P file     start from an RLE pattern (centred) instead
+               of a random board; its rule applies unless -r
+   -C file     checkpoint the board to file at the end of the run
+   -K K        ... and every K-th generation
+   -R file     restart from a checkpoint and run up to TimeSteps
+   -S file     write population, births and deaths of every
+               generation to file (CSV), counted inside the
+               update kernel (dense, packed, flat, simd)
+
+ Snapshots are written by a background thread; turn a
+ stream into PGM images with ./snap2pgm file. For
+ throughput sweeps over sizes and threads see ./life_bench
  ******************************************************/
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/time.h>
+#include "life.h"
 
-#define FINALIZE "\
-convert -delay 20 `ls -1 out*.pgm | sort -V` output.gif\n\
-rm *pgm\n\
-"
-
-int ** allocate_array(int N);
-void free_array(int ** array, int N);
-void init_random(int ** array1, int ** array2, int N);
-void print_to_pgm( int ** array, int N, int t );
+static void usage(char * argv0) {
+	int i;
+	fprintf(stderr, "Usage: %s [-e engine] [-r rule] [-t] [-b B] [-d D] [-m MB] [-v] [-p] [-c] [-o file] [-k K] [-s seed] [-P file] [-C file] [-K K] [-R file] [-S file] ArraySize TimeSteps\n", argv0);
+	fprintf(stderr, "       engines:");
+	for ( i = 0 ; life_engines[i] ; i++ )
+		fprintf(stderr, " %s", life_engines[i]->name);
+	fprintf(stderr, "\n");
+	exit(-1);
+}
 
 int main (int argc, char * argv[]) {
-	int N;	 			//array dimensions
-	int T; 				//time steps
-	int ** current, ** previous; 	//arrays - one for current timestep, one for previous timestep
-	int ** swap;			//array pointer
-	int t, i, j, nbrs;		//helper variables
+	struct life_params p = { 0 };
+	const struct life_engine * engine = &dense_engine;
+	int check = 0;			//compare against the dense engine
+	int ** board;			//initial board, then final board
+	int ** initial = NULL;		//copy of the initial board for -c
+	void * ctx;
+	char * snap_path = NULL;	//snapshot stream, if any
+	struct snapshot * snap = NULL;
+	int every = 1;			//snapshot interval
+	char * ckpt_path = NULL;	//checkpoint file, if any
+	char * restart_path = NULL;	//checkpoint to restart from, if any
+	int ckpt_every = 0;		//checkpoint interval, 0: only at the end
+	unsigned int seed = 1;		//seed of the initial fill
+	char * pattern_path = NULL;	//RLE pattern instead of the random fill
+	int rule_given = 0;		//-r overrides the pattern's rule
+	char * stats_path = NULL;	//per-generation statistics, if any
+	FILE * stats_file = NULL;
+	struct life_stats * series = NULL;	//statistics of every generation run, for -c
+	const struct life_stats * st;
+	int t0 = 0;			//first generation (non-zero on restart)
+	int t, n, opt, diff, N, k;
+	double cells;			//cells updated per generation
+	double rate;			//cell updates per second
+	double ckpt_time = 0;		//time spent writing checkpoints
 
 	double time;			//variables for timing
-	struct timeval ts,tf;
+	struct timeval ts,tf,cs,cf;
+
+	p.tile = 128;
+	p.depth = 8;
+	p.cache_mb = 1024;
+	rule_parse("B3/S23", &p.rule);
 
 	/*Read input arguments*/
-	if ( argc != 3 ) {
-		fprintf(stderr, "Usage: ./exec ArraySize TimeSteps\n");
-		exit(-1);
+	while ( (opt = getopt(argc, argv, "e:r:tb:d:m:vpco:k:s:P:C:K:R:S:h")) != -1 ) {
+		switch (opt) {
+			case 'e':
+				engine = find_engine(optarg);
+				if ( !engine ) {
+					fprintf(stderr, "Unknown engine '%s'\n", optarg);
+					usage(argv[0]);
+				}
+				break;
+			case 'r':
+				if ( rule_parse(optarg, &p.rule) ) {
+					fprintf(stderr, "Bad rule '%s'\n", optarg);
+					usage(argv[0]);
+				}
+				rule_given = 1;
+				break;
+			case 't':
+				p.torus = 1;
+				break;
+			case 'b':
+				p.tile = atoi(optarg);
+				break;
+			case 'd':
+				p.depth = atoi(optarg);
+				break;
+			case 'm':
+				p.cache_mb = atoi(optarg);
+				break;
+			case 'v':
+				p.verbose = 1;
+				break;
+			case 'p':
+				p.pin = 1;
+				break;
+			case 'c':
+				check = 1;
+				break;
+			case 'o':
+				snap_path = optarg;
+				break;
+			case 'k':
+				every = atoi(optarg);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'P':
+				pattern_path = optarg;
+				break;
+			case 'C':
+				ckpt_path = optarg;
+				break;
+			case 'K':
+				ckpt_every = atoi(optarg);
+				break;
+			case 'R':
+				restart_path = optarg;
+				break;
+			case 'S':
+				stats_path = optarg;
+				p.stats = 1;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if ( argc - optind != 2 || p.tile < 1 || p.depth < 1 || every < 1 || ckpt_every < 0 )
+		usage(argv[0]);
+	p.N = atoi(argv[optind]);
+	p.T = atoi(argv[optind+1]);
+
+	/*Allocate and initialize board*/
+	if ( restart_path ) {
+		board = checkpoint_read(restart_path, &N, &t0, &seed);
+		if ( !board ) {
+			fprintf(stderr, "%s: not a checkpoint\n", restart_path);
+			exit(-1);
+		}
+		if ( N != p.N ) {
+			fprintf(stderr, "%s: checkpoint is for size %d, not %d\n", restart_path, N, p.N);
+			exit(-1);
+		}
+		if ( t0 > p.T ) {
+			fprintf(stderr, "%s: checkpoint is already at generation %d\n", restart_path, t0);
+			exit(-1);
+		}
+		printf("Restart: %s Generation %d Seed %u\n", restart_path, t0, seed);
+	}
+	else if ( pattern_path ) {
+		board = allocate_array(p.N);
+		if ( pattern_load(pattern_path, board, p.N, rule_given ? NULL : &p.rule) )
+			exit(-1);
+		printf("Pattern: %s\n", pattern_path);
 	}
 	else {
-		N = atoi(argv[1]);
-		T = atoi(argv[2]);
+		board = allocate_array(p.N);
+		init_random(board, p.N, seed);	//initialize board with pattern
 	}
 
-	/*Allocate and initialize matrices*/
-	current = allocate_array(N);			//allocate array for current time step
-	previous = allocate_array(N); 			//allocate array for previous time step
+	if ( !engine->any_rule && !RULE_IS(&p.rule, 0x008, 0x00c) ) {
+		fprintf(stderr, "Engine %s only runs B3/S23, not %s\n", engine->name, p.rule.name);
+		exit(-1);
+	}
+	if ( p.torus && !engine->torus ) {
+		fprintf(stderr, "Engine %s has no torus mode\n", engine->name);
+		exit(-1);
+	}
+	if ( p.stats && !engine->stats ) {
+		fprintf(stderr, "Engine %s does not count statistics\n", engine->name);
+		exit(-1);
+	}
 
-	init_random(previous, current, N);	//initialize previous array with pattern
+	if ( check ) {
+		initial = allocate_array(p.N);
+		copy_array(initial, board, p.N);
+	}
 
-	#ifdef OUTPUT
-	print_to_pgm(previous, N, 0);
-	#endif
+	if ( snap_path ) {
+		snap = snapshot_open(snap_path, p.N, every);
+		snapshot_put(snap, board, t0);
+	}
+
+	if ( stats_path ) {
+		stats_file = fopen(stats_path, "w");
+		if ( !stats_file ) {
+			perror(stats_path);
+			exit(-1);
+		}
+		series = calloc(p.T - t0 + 1, sizeof(struct life_stats));
+		series[0].population = board_population(board, p.N);
+		fprintf(stats_file, "generation,population,births,deaths\n");
+		fprintf(stats_file, "%d,%ld,0,0\n", t0, series[0].population);
+	}
 
 	/*Game of Life*/
 
+	ctx = engine->init(board, &p);
 	gettimeofday(&ts,NULL);
-	for ( t = 0 ; t < T ; t++ ) {
-		for ( i = 1 ; i < N-1 ; i++ )
-			for ( j = 1 ; j < N-1 ; j++ ) {
-				nbrs = previous[i+1][j+1] + previous[i+1][j] + previous[i+1][j-1] \
-				       + previous[i][j-1] + previous[i][j+1] \
-				       + previous[i-1][j-1] + previous[i-1][j] + previous[i-1][j+1];
-				if ( nbrs == 3 || ( previous[i][j]+nbrs ==3 ) )
-					current[i][j]=1;
-				else 
-					current[i][j]=0;
-			}
-
-		#ifdef OUTPUT
-		print_to_pgm(current, N, t+1);
-		#endif
-		//Swap current array with previous array 
-		swap=current;
-		current=previous;
-		previous=swap;
+	for ( t = t0 ; t < p.T ; t += n ) {
+		//run up to the next snapshot or checkpoint
+		n = p.T-t;
+		if ( snap && every - t%every < n )
+			n = every - t%every;
+		if ( ckpt_path && ckpt_every && ckpt_every - t%ckpt_every < n )
+			n = ckpt_every - t%ckpt_every;
+		engine->step(ctx, n);
 
+		if ( stats_file ) {
+			st = engine->stats(ctx);
+			for ( k = 0 ; k < n ; k++ ) {
+				series[t-t0+k+1] = st[k];
+				fprintf(stats_file, "%d,%ld,%ld,%ld\n", t+k+1, st[k].population, st[k].births, st[k].deaths);
+			}
+		}
+		if ( snap && ( (t+n)%every == 0 || t+n == p.T ) ) {
+			engine->get(ctx, board);
+			snapshot_put(snap, board, t+n);
+		}
+		if ( ckpt_path && ( (ckpt_every && (t+n)%ckpt_every == 0) || t+n == p.T ) ) {
+			gettimeofday(&cs,NULL);
+			engine->get(ctx, board);
+			if ( checkpoint_write(ckpt_path, board, p.N, t+n, seed) )
+				exit(-1);
+			gettimeofday(&cf,NULL);
+			ckpt_time += (cf.tv_sec-cs.tv_sec)+(cf.tv_usec-cs.tv_usec)*0.000001;
+		}
 	}
 	gettimeofday(&tf,NULL);
 	time=(tf.tv_sec-ts.tv_sec)+(tf.tv_usec-ts.tv_usec)*0.000001;
 
-	free_array(current, N);
-	free_array(previous, N);
-	printf("GameOfLife: Size %d Steps %d Time %lf\n", N, T, time);
-	#ifdef OUTPUT
-	system(FINALIZE);
-	#endif
-}
-
-int ** allocate_array(int N) {
-	int ** array;
-	int i,j;
-	array = malloc(N * sizeof(int*));
-	for ( i = 0; i < N ; i++ ) 
-		array[i] = malloc( N * sizeof(int));
-	for ( i = 0; i < N ; i++ )
-		for ( j = 0; j < N ; j++ )
-			array[i][j] = 0;
-	return array;
-}
-
-void free_array(int ** array, int N) {
-	int i;
-	for ( i = 0 ; i < N ; i++ )
-		free(array[i]);
-	free(array);
-}
-
-void init_random(int ** array1, int ** array2, int N) {
-	int i,pos,x,y;
-
-	for ( i = 0 ; i < (N * N)/10 ; i++ ) {
-		pos = rand() % ((N-2)*(N-2));
-		array1[pos%(N-2)+1][pos/(N-2)+1] = 1;
-		array2[pos%(N-2)+1][pos/(N-2)+1] = 1;
+	engine->get(ctx, board);
+	p.T -= t0;			//steps actually run
+	cells = p.torus ? (double)p.N*p.N : (double)(p.N-2)*(p.N-2);
+	rate = time > 0 ? cells*p.T/time : 0;
+	printf("GameOfLife: Size %d Steps %d Time %lf Engine %s CellsPerSec %.4e", p.N, p.T, time, engine->name, rate);
+	if ( !RULE_IS(&p.rule, 0x008, 0x00c) )
+		printf(" Rule %s", p.rule.name);
+	if ( p.torus )
+		printf(" Torus");
+	printf("\n");
+	if ( ckpt_path )
+		printf("Checkpoint: %s Generation %d Time %lf\n", ckpt_path, t0+p.T, ckpt_time);
+	if ( engine->report )
+		engine->report(ctx);
+	engine->finalize(ctx);
+	if ( snap )
+		printf("Snapshot: %s Bytes %ld\n", snap_path, snapshot_close(snap));
+	if ( stats_file ) {
+		fclose(stats_file);
+		printf("Stats: %s Population %ld\n", stats_path, series[p.T].population);
+	}
 
+	if ( check ) {
+		ctx = dense_engine.init(initial, &p);
+		dense_engine.step(ctx, p.T);
+		dense_engine.get(ctx, initial);
+		diff = compare_array(board, initial, p.N);
+		if ( diff )
+			printf("Check: FAILED (%d cells differ from dense)\n", diff);
+		else if ( series && p.T > 0 && memcmp(series + 1, dense_engine.stats(ctx), p.T * sizeof(struct life_stats)) )
+			printf("Check: FAILED (statistics differ from dense)\n");
+		else
+			printf("Check: OK\n");
+		dense_engine.finalize(ctx);
+		free_array(initial, p.N);
 	}
-}
 
-void print_to_pgm(int ** array, int N, int t) {
-	int i,j;
-	char * s = malloc(30*sizeof(char));
-	sprintf(s,"out%d.pgm",t);
-	FILE * f = fopen(s,"wb");
-	fprintf(f, "P5\n%d %d 1\n", N,N);
-	for ( i = 0; i < N ; i++ ) 
-		for ( j = 0; j < N ; j++)
-			if ( array[i][j]==1 )
-				fputc(1,f);
-			else
-				fputc(0,f);
-	fclose(f);
-	free(s);
+	free(series);
+	free_array(board, p.N);
+	return 0;
 }
-
@@ -0,0 +1,157 @@
+/*
+ * Checkpoint/restart.
+ *
+ * A checkpoint is a page-sized header (generation counter and the seed of
+ * the initial fill) followed by the board bit-packed the same way
+ * as snapshot frames: N rows of (N+7)/8 bytes, cell j in bit j%8 of byte
+ * j/8. Both directions go through mmap, so writing and loading are a single
+ * pass over the mapped file, rows packed/unpacked in parallel, and cost what
+ * the storage bandwidth allows instead of N^2 library calls. A checkpoint is
+ * written to <path>.tmp and renamed over <path>, so a crash while writing
+ * leaves the previous checkpoint intact.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "life.h"
+
+#define CKPT_MAGIC	"LIFECKPT"
+#define CKPT_VERSION	1
+#define CKPT_DATA	4096		//offset of the board in the file
+
+struct ckpt_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t N;
+	uint64_t generation;
+	uint32_t seed;			//seed of the initial random fill
+	uint32_t reserved;		//reserved, written as 0
+	uint64_t row_bytes;
+};
+
+/* Write board at generation t to path, return 0 on success */
+int checkpoint_write(const char * path, int ** board, int N, int t, unsigned int seed) {
+	size_t row_bytes = (N + 7) / 8, size = CKPT_DATA + row_bytes * N;
+	char * tmp = malloc(strlen(path) + 5);
+	struct ckpt_header * h;
+	unsigned char * map, * data;
+	int fd, i;
+
+	sprintf(tmp, "%s.tmp", path);
+	fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if ( fd < 0 ) {
+		perror(tmp);
+		free(tmp);
+		return -1;
+	}
+	if ( ftruncate(fd, size) ) {
+		perror(tmp);
+		close(fd);
+		unlink(tmp);
+		free(tmp);
+		return -1;
+	}
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if ( map == MAP_FAILED ) {
+		perror("mmap");
+		close(fd);
+		unlink(tmp);
+		free(tmp);
+		return -1;
+	}
+
+	h = (struct ckpt_header *)map;
+	memcpy(h->magic, CKPT_MAGIC, 8);
+	h->version = CKPT_VERSION;
+	h->N = N;
+	h->generation = t;
+	h->seed = seed;
+	h->row_bytes = row_bytes;
+
+	data = map + CKPT_DATA;
+	#pragma omp parallel for schedule(static)
+	for ( i = 0 ; i < N ; i++ ) {
+		unsigned char * row = data + (size_t)i * row_bytes;
+		int j;
+		for ( j = 0 ; j < N ; j++ )
+			row[j/8] |= (board[i][j] != 0) << (j%8);	//file is zero-filled by ftruncate
+	}
+
+	msync(map, size, MS_SYNC);
+	munmap(map, size);
+	close(fd);
+	if ( rename(tmp, path) ) {
+		perror(path);
+		free(tmp);
+		return -1;
+	}
+	free(tmp);
+	return 0;
+}
+
+/*
+ * Map the checkpoint at path and return its board (allocated with
+ * allocate_array), or NULL if it is not a valid checkpoint. The header is
+ * checked before anything is allocated from it: 3 <= N <= INT_MAX, the
+ * generation fits an int and the file is exactly the header page plus N
+ * packed rows, as checkpoint_write leaves it.
+ */
+int ** checkpoint_read(const char * path, int * N, int * t, unsigned int * seed) {
+	const struct ckpt_header * h;
+	const unsigned char * map, * data;
+	struct stat st;
+	int ** board;
+	int fd, i;
+
+	fd = open(path, O_RDONLY);
+	if ( fd < 0 ) {
+		perror(path);
+		return NULL;
+	}
+	if ( fstat(fd, &st) ) {
+		perror(path);
+		close(fd);
+		return NULL;
+	}
+	if ( st.st_size < CKPT_DATA ) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( map == MAP_FAILED ) {
+		perror("mmap");
+		return NULL;
+	}
+	h = (const struct ckpt_header *)map;
+	if ( memcmp(h->magic, CKPT_MAGIC, 8) || h->version != CKPT_VERSION
+	     || h->N < 3 || h->N > INT_MAX || h->generation > INT_MAX
+	     || h->row_bytes != (h->N + 7) / 8
+	     || (uint64_t)st.st_size != CKPT_DATA + h->row_bytes * h->N ) {
+		munmap((void *)map, st.st_size);
+		return NULL;
+	}
+	madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+
+	*N = h->N;
+	*t = h->generation;
+	*seed = h->seed;
+	board = allocate_array(*N);
+	data = map + CKPT_DATA;
+	#pragma omp parallel for schedule(static)
+	for ( i = 0 ; i < *N ; i++ ) {
+		const unsigned char * row = data + (size_t)i * h->row_bytes;
+		int j;
+		for ( j = 0 ; j < *N ; j++ )
+			board[i][j] = (row[j/8] >> (j%8)) & 1;
+	}
+	munmap((void *)map, st.st_size);
+	return board;
+}
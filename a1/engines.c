@@ -0,0 +1,26 @@
+/*
+ * Table of all engines, shared by the driver and the benchmark.
+ */
+
+#include <string.h>
+#include "life.h"
+
+const struct life_engine * const life_engines[] = {
+	&dense_engine,
+	&packed_engine,
+	&omp_engine,
+	&tiled_engine,
+	&sparse_engine,
+	&hashlife_engine,
+	&flat_engine,
+	&simd_engine,
+	NULL
+};
+
+const struct life_engine * find_engine(const char * name) {
+	int i;
+	for ( i = 0 ; life_engines[i] ; i++ )
+		if ( strcmp(life_engines[i]->name, name) == 0 )
+			return life_engines[i];
+	return NULL;
+}
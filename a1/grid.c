@@ -0,0 +1,70 @@
+/*
+ * Contiguous board layout shared by the byte-per-cell engines.
+ *
+ * The whole board is one 64-byte aligned block of unsigned char cells with
+ * a ghost row above and below and a ghost column left and right of the
+ * N x N board. Every row starts on a cache line: the left ghost cell is the
+ * last byte of the 64 bytes in front of column 0, and the stride is padded
+ * to a multiple of 64. Kernels index cells directly as
+ * cells[i*stride + j], with i, j running from -1 to N.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+
+void grid_alloc(struct grid * g, int N) {
+	int i;
+
+	g->N = N;
+	g->stride = (64 + N + 1 + 63) / 64 * 64;
+	g->size = (size_t)(N + 2) * g->stride;
+	g->mem = aligned_alloc(64, g->size);
+	if ( !g->mem ) {
+		fprintf(stderr, "grid_alloc: out of memory\n");
+		exit(1);
+	}
+	g->cells = g->mem + g->stride + 64;
+
+	//zero in the same static row split the engines compute with, so
+	//the pages are first-touched by the thread that will use them
+	#pragma omp parallel for schedule(static)
+	for ( i = -1 ; i <= N ; i++ )
+		memset(g->cells + (ptrdiff_t)i * g->stride - 64, 0, g->stride);
+}
+
+void grid_free(struct grid * g) {
+	free(g->mem);
+	g->mem = g->cells = NULL;
+}
+
+void grid_load(struct grid * g, int ** board) {
+	int i, j;
+
+	#pragma omp parallel for schedule(static) private(j)
+	for ( i = 0 ; i < g->N ; i++ )
+		for ( j = 0 ; j < g->N ; j++ )
+			CELL(g, i, j) = board[i][j] != 0;
+}
+
+void grid_store(struct grid * g, int ** board) {
+	int i, j;
+
+	#pragma omp parallel for schedule(static) private(j)
+	for ( i = 0 ; i < g->N ; i++ )
+		for ( j = 0 ; j < g->N ; j++ )
+			board[i][j] = CELL(g, i, j);
+}
+
+/* Fill the ghost border from the opposite edges (torus) */
+void grid_wrap(struct grid * g) {
+	int N = g->N, i;
+
+	memcpy(&CELL(g, -1, 0), &CELL(g, N-1, 0), N);
+	memcpy(&CELL(g, N, 0), &CELL(g, 0, 0), N);
+	for ( i = -1 ; i <= N ; i++ ) {
+		CELL(g, i, -1) = CELL(g, i, N-1);
+		CELL(g, i, N) = CELL(g, i, 0);
+	}
+}
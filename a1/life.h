@@ -0,0 +1,156 @@
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Shared declarations for the Game of Life driver and its engines.
+ *
+ * Every engine receives the initial board in the dense int ** form used by
+ * the original program (N x N cells, dead frame on rows/columns 0 and N-1),
+ * keeps it in whatever representation it likes, and hands it back in the
+ * same dense form when asked. The driver only ever talks to engines through
+ * struct life_engine.
+ *
+ * With life_params.torus set there is no frame: all N x N cells are live
+ * and the board wraps around at its edges. Engines that support it keep a
+ * ghost border, refresh it from the opposite edges before each generation
+ * and run their unchanged interior kernel over all N x N cells.
+ */
+
+/*
+ * Life-like rule: bit n of birth/survive set means a dead/live cell with n
+ * live neighbours is alive in the next generation. KNOWN_RULES lists
+ * (name, B/S string, birth, survive) of the rules the flat and packed
+ * engines instantiate specialized kernels for; they, and the dense and
+ * simd engines, which only special-case B3/S23, handle any other rule
+ * through runtime tables or masks.
+ */
+struct life_rule {
+	unsigned int birth, survive;
+	char name[24];			//canonical "B.../S..." form
+};
+
+#define KNOWN_RULES(X) \
+	X(conway,	"B3/S23",	0x008, 0x00c) \
+	X(highlife,	"B36/S23",	0x048, 0x00c) \
+	X(daynight,	"B3678/S34678",	0x1c8, 0x1d8) \
+	X(seeds,	"B2/S",		0x004, 0x000)
+
+#define RULE_IS(r, b, s)	((r)->birth == (b) && (r)->survive == (s))
+
+/*
+ * Next state of one cell. With birth and survive compile-time constants
+ * this folds into a handful of compares, which vectorize in byte lanes.
+ */
+static inline __attribute__((always_inline))
+unsigned char rule_cell(unsigned char nbrs, unsigned char self, unsigned int birth, unsigned int survive) {
+	unsigned char b = 0, s = 0;
+
+	if ( birth == 0x008 && survive == 0x00c )
+		return ( nbrs | self ) == 3;
+#define RULE_COUNT(n) \
+	if ( birth >> n & 1 ) \
+		b |= nbrs == n; \
+	if ( survive >> n & 1 ) \
+		s |= nbrs == n;
+	RULE_COUNT(0) RULE_COUNT(1) RULE_COUNT(2) RULE_COUNT(3) RULE_COUNT(4)
+	RULE_COUNT(5) RULE_COUNT(6) RULE_COUNT(7) RULE_COUNT(8)
+#undef RULE_COUNT
+	return self ? s : b;
+}
+
+struct life_params {
+	int N;				//array dimensions
+	int T;				//time steps
+	struct life_rule rule;		//B/S rule, Conway's B3/S23 by default
+	int torus;			//wrap around instead of a dead frame
+	int pin;			//pin worker threads to cores
+	int tile;			//tile edge in cells (tiled, sparse engines)
+	int depth;			//generations per tile visit (tiled engine)
+	int verbose;			//per-step engine output
+	int cache_mb;			//node cache limit in MB (hashlife engine)
+	int stats;			//count population, births, deaths every generation
+};
+
+/* Counts of one generation, from the update kernel itself (see -S) */
+struct life_stats {
+	long population;
+	long births;
+	long deaths;
+};
+
+struct life_engine {
+	const char * name;
+	void * (*init)(int ** board, const struct life_params * p);	//copy board in, return engine state
+	void (*step)(void * ctx, int steps);				//advance the board by steps generations
+	void (*get)(void * ctx, int ** board);				//copy current generation out
+	void (*finalize)(void * ctx);					//free engine state
+	void (*report)(void * ctx);					//optional: print engine statistics
+	int any_rule;							//supports rules other than B3/S23
+	int torus;							//supports the wrap-around board
+	const struct life_stats * (*stats)(void * ctx);			//optional: one entry per generation of the last step
+};
+
+/* Contiguous byte-per-cell board with a ghost border, see grid.c */
+struct grid {
+	int N;
+	size_t stride;			//bytes per row, multiple of 64
+	size_t size;			//bytes in mem
+	unsigned char * mem;		//64-byte aligned block
+	unsigned char * cells;		//cell (0,0), on a cache line boundary
+};
+
+#define CELL(g,i,j)	((g)->cells[(ptrdiff_t)(i)*(ptrdiff_t)(g)->stride + (j)])
+
+extern const struct life_engine dense_engine;
+extern const struct life_engine packed_engine;
+extern const struct life_engine omp_engine;
+extern const struct life_engine tiled_engine;
+extern const struct life_engine sparse_engine;
+extern const struct life_engine hashlife_engine;
+extern const struct life_engine flat_engine;
+extern const struct life_engine simd_engine;
+
+/* engines.c */
+extern const struct life_engine * const life_engines[];	//NULL-terminated
+const struct life_engine * find_engine(const char * name);
+
+/* utils.c */
+int ** allocate_array(int N);
+void free_array(int ** array, int N);
+void copy_array(int ** dst, int ** src, int N);
+int compare_array(int ** a, int ** b, int N);
+long board_population(int ** board, int N);
+int random_cell(unsigned int seed, int i, int j);
+void init_random(int ** array, int N, unsigned int seed);
+void pin_thread(int tid);
+
+/* rule.c */
+int rule_parse(const char * s, struct life_rule * r);
+void rule_name(struct life_rule * r);
+
+/* grid.c */
+void grid_alloc(struct grid * g, int N);
+void grid_free(struct grid * g);
+void grid_load(struct grid * g, int ** board);
+void grid_store(struct grid * g, int ** board);
+void grid_wrap(struct grid * g);
+
+/* snapshot.c */
+struct snapshot;
+struct snapshot * snapshot_open(const char * path, int N, int every);
+void snapshot_put(struct snapshot * s, int ** board, int t);
+long snapshot_close(struct snapshot * s);
+int snapshot_read_header(FILE * f, int * N, int * every);
+int snapshot_read_frame(FILE * f, int N, int ** board, int * t);
+
+/* checkpoint.c */
+int checkpoint_write(const char * path, int ** board, int N, int t, unsigned int seed);
+int ** checkpoint_read(const char * path, int * N, int * t, unsigned int * seed);
+
+/* pattern.c */
+int pattern_load(const char * path, int ** board, int N, struct life_rule * rule);
+
+#endif /* LIFE_H */
@@ -0,0 +1,306 @@
+/******************************************************
+ ********** Game of Life throughput benchmark *********
+ ******************************************************
+
+ Usage: ./life_bench [options]
+
+ Sweeps engines x board sizes x thread counts. Every
+ configuration is initialized once, advanced -w times
+ untimed (warm-up: page faults, caches, frequency), then
+ timed -k times; the median, standard deviation and best
+ time are reported as cell updates per second and as
+ achieved GB/s. Achieved bandwidth assumes the minimal
+ traffic of one sweep (read the previous board, write
+ the next one) and is compared with a STREAM copy run
+ at the same thread count (the "roofline" column).
+
+ Options:
+   -e list     engines, comma separated (default: all but
+               hashlife, whose cost is not per cell)
+   -n list     board sizes (default: one size resident in
+               each of L1, L2, LLC and DRAM, from sysconf,
+               capped at 1/64 of physical memory per cell)
+   -j list     OpenMP thread counts (default: 1)
+   -u U        cell updates per timed run (default 2e8);
+               steps = U / N^2, at least 1
+   -w W        warm-up runs (default 1)
+   -k K        timed runs (default 5)
+   -r rule     B/S rule (default B3/S23)
+   -t          torus instead of a dead frame
+   -o file     also write the results as CSV to file
+ ******************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+#include "life.h"
+
+#define MAX_LIST	32
+
+/*
+ * Bytes moved per cell update by one sweep over the board: the previous
+ * generation is read and the next one written, in the engine's own cell
+ * size. 0 for engines whose work is not proportional to the board.
+ */
+static const struct {
+	const char * name;
+	double bytes;
+} traffic[] = {
+	{ "dense", 2 * sizeof(int) },
+	{ "omp", 2 * sizeof(int) },
+	{ "tiled", 2 * sizeof(int) },
+	{ "sparse", 2 * sizeof(int) },
+	{ "packed", 2 / 8.0 },
+	{ "flat", 2 },
+	{ "simd", 2 },
+	{ "hashlife", 0 },
+};
+
+static double cell_bytes(const char * name) {
+	unsigned int i;
+	for ( i = 0 ; i < sizeof(traffic)/sizeof(traffic[0]) ; i++ )
+		if ( strcmp(traffic[i].name, name) == 0 )
+			return traffic[i].bytes;
+	return 0;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Data cache sizes in bytes (L1, L2, LLC), with fallbacks where sysconf does not know */
+static void cache_sizes(long cache[3]) {
+	cache[0] = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+	cache[1] = sysconf(_SC_LEVEL2_CACHE_SIZE);
+	cache[2] = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	if ( cache[0] <= 0 ) cache[0] = 32 << 10;
+	if ( cache[1] <= 0 ) cache[1] = 1 << 20;
+	if ( cache[2] <= 0 ) cache[2] = cache[1];
+}
+
+static const char * level(double bytes, const long cache[3]) {
+	if ( bytes <= cache[0] ) return "L1";
+	if ( bytes <= cache[1] ) return "L2";
+	if ( bytes <= cache[2] ) return "LLC";
+	return "DRAM";
+}
+
+/* Best-of-5 STREAM copy bandwidth in GB/s over arrays of n doubles */
+static double stream_copy(size_t n) {
+	double * a = malloc(n * sizeof(double)), * b = malloc(n * sizeof(double));
+	double t, best = 0;
+	size_t i;
+	int k;
+
+	#pragma omp parallel for schedule(static)
+	for ( i = 0 ; i < n ; i++ ) {
+		a[i] = 1.0;
+		b[i] = 0.0;
+	}
+	for ( k = 0 ; k < 5 ; k++ ) {
+		t = now();
+		#pragma omp parallel for schedule(static)
+		for ( i = 0 ; i < n ; i++ )
+			b[i] = a[i];
+		t = now() - t;
+		if ( t > 0 && 2 * n * sizeof(double) / t > best )
+			best = 2 * n * sizeof(double) / t;
+	}
+	if ( b[n/2] != 1.0 )
+		fprintf(stderr, "stream_copy: bad result\n");
+	free(a);
+	free(b);
+	return best * 1e-9;
+}
+
+static int cmp_double(const void * a, const void * b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+/* Split a comma separated list of integers into v, return the count */
+static int parse_list(char * s, int * v) {
+	char * tok;
+	int n = 0;
+
+	for ( tok = strtok(s, ",") ; tok && n < MAX_LIST ; tok = strtok(NULL, ",") )
+		v[n++] = atoi(tok);
+	return n;
+}
+
+static void usage(char * argv0) {
+	int i;
+	fprintf(stderr, "Usage: %s [-e engine,...] [-n N,...] [-j threads,...] [-u U] [-w W] [-k K] [-r rule] [-t] [-o file.csv]\n", argv0);
+	fprintf(stderr, "       engines:");
+	for ( i = 0 ; life_engines[i] ; i++ )
+		fprintf(stderr, " %s", life_engines[i]->name);
+	fprintf(stderr, "\n");
+	exit(-1);
+}
+
+int main(int argc, char * argv[]) {
+	struct life_params p = { 0 };
+	const struct life_engine * engines[MAX_LIST];
+	int sizes[MAX_LIST], threads[MAX_LIST];
+	int nengines = 0, nsizes = 0, nthreads = 0;
+	int warmup = 1, reps = 5;
+	double updates = 2e8;
+	char * csv_path = NULL, * tok;
+	FILE * csv = NULL;
+	long cache[3], max_cells;
+	int e, s, h, k, opt, steps;
+	int ** board;
+	void * ctx;
+	double * times, t, median, mean, dev, cells, rate, gbs, bytes, stream;
+
+	p.tile = 128;
+	p.depth = 8;
+	p.cache_mb = 1024;
+	rule_parse("B3/S23", &p.rule);
+
+	while ( (opt = getopt(argc, argv, "e:n:j:u:w:k:r:to:h")) != -1 ) {
+		switch (opt) {
+			case 'e':
+				for ( tok = strtok(optarg, ",") ; tok && nengines < MAX_LIST ; tok = strtok(NULL, ",") )
+					if ( !(engines[nengines++] = find_engine(tok)) ) {
+						fprintf(stderr, "Unknown engine '%s'\n", tok);
+						usage(argv[0]);
+					}
+				break;
+			case 'n':
+				nsizes = parse_list(optarg, sizes);
+				break;
+			case 'j':
+				nthreads = parse_list(optarg, threads);
+				break;
+			case 'u':
+				updates = atof(optarg);
+				break;
+			case 'w':
+				warmup = atoi(optarg);
+				break;
+			case 'k':
+				reps = atoi(optarg);
+				break;
+			case 'r':
+				if ( rule_parse(optarg, &p.rule) ) {
+					fprintf(stderr, "Bad rule '%s'\n", optarg);
+					usage(argv[0]);
+				}
+				break;
+			case 't':
+				p.torus = 1;
+				break;
+			case 'o':
+				csv_path = optarg;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if ( optind != argc || reps < 1 || warmup < 0 || updates < 1 )
+		usage(argv[0]);
+
+	cache_sizes(cache);
+	if ( !nengines )
+		for ( e = 0 ; life_engines[e] ; e++ )
+			if ( life_engines[e] != &hashlife_engine )
+				engines[nengines++] = life_engines[e];
+	if ( !nsizes ) {
+		//two byte boards filling half of each cache level, then 4x the LLC;
+		//int engines need up to 16 bytes per cell, leave room for that
+		max_cells = sysconf(_SC_PHYS_PAGES) / 64 * sysconf(_SC_PAGESIZE);
+		for ( k = 0 ; k < 3 ; k++ )
+			sizes[nsizes++] = sqrt(cache[k] / 4.0);
+		sizes[nsizes++] = sqrt(cache[2] * 2.0);
+		for ( k = 0 ; k < nsizes ; k++ )
+			if ( max_cells > 0 && (double)sizes[k] * sizes[k] > max_cells )
+				sizes[k] = sqrt(max_cells);
+	}
+	if ( !nthreads )
+		threads[nthreads++] = 1;
+
+	printf("Caches: L1 %ld L2 %ld LLC %ld Bytes\n", cache[0], cache[1], cache[2]);
+	if ( csv_path ) {
+		csv = fopen(csv_path, "w");
+		if ( !csv ) {
+			perror(csv_path);
+			exit(-1);
+		}
+		fprintf(csv, "engine,rule,torus,size,level,threads,steps,reps,median_s,stddev_s,min_s,"
+			     "cells_per_s,gb_per_s,stream_copy_gb_per_s,roofline\n");
+	}
+	times = malloc(reps * sizeof(double));
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	for ( h = 0 ; h < nthreads ; h++ ) {
+		omp_set_num_threads(threads[h]);
+		stream = stream_copy(cache[2] < (8 << 20) ? (4 << 20) : cache[2] / 2);
+		printf("Stream: Threads %d CopyGBs %.2f\n", threads[h], stream);
+
+		for ( s = 0 ; s < nsizes ; s++ ) {
+			p.N = sizes[s];
+			if ( p.N < 4 )
+				continue;
+			cells = p.torus ? (double)p.N*p.N : (double)(p.N-2)*(p.N-2);
+			steps = updates / cells > 1 ? updates / cells : 1;
+			p.T = steps;
+
+			board = allocate_array(p.N);
+			init_random(board, p.N, 1);
+
+			for ( e = 0 ; e < nengines ; e++ ) {
+				if ( ( !engines[e]->any_rule && !RULE_IS(&p.rule, 0x008, 0x00c) )
+				     || ( p.torus && !engines[e]->torus ) )
+					continue;
+
+				ctx = engines[e]->init(board, &p);
+				for ( k = 0 ; k < warmup ; k++ )
+					engines[e]->step(ctx, steps);
+				for ( k = 0 ; k < reps ; k++ ) {
+					t = now();
+					engines[e]->step(ctx, steps);
+					times[k] = now() - t;
+				}
+				engines[e]->finalize(ctx);
+
+				mean = 0;
+				for ( k = 0 ; k < reps ; k++ )
+					mean += times[k] / reps;
+				dev = 0;
+				for ( k = 0 ; k < reps ; k++ )
+					dev += (times[k] - mean) * (times[k] - mean);
+				dev = reps > 1 ? sqrt(dev / (reps - 1)) : 0;
+				qsort(times, reps, sizeof(double), cmp_double);
+				median = reps % 2 ? times[reps/2] : (times[reps/2-1] + times[reps/2]) / 2;
+
+				bytes = cell_bytes(engines[e]->name);
+				rate = median > 0 ? cells * steps / median : 0;
+				gbs = rate * bytes * 1e-9;
+				printf("Bench: Engine %s Size %d Level %s Threads %d Steps %d Median %lf Stddev %lf "
+				       "CellsPerSec %.4e GBs %.2f Roofline %.0f%%\n",
+				       engines[e]->name, p.N, level(p.N * (double)p.N * bytes, cache), threads[h],
+				       steps, median, dev, rate, gbs, stream > 0 ? 100 * gbs / stream : 0);
+				if ( csv ) {
+					fprintf(csv, "%s,%s,%d,%d,%s,%d,%d,%d,%.6f,%.6f,%.6f,%.4e,%.3f,%.3f,%.3f\n",
+						engines[e]->name, p.rule.name, p.torus, p.N,
+						level(p.N * (double)p.N * bytes, cache), threads[h], steps, reps,
+						median, dev, times[0], rate, gbs, stream, stream > 0 ? gbs / stream : 0);
+					fflush(csv);
+				}
+			}
+			free_array(board, p.N);
+		}
+	}
+
+	free(times);
+	if ( csv )
+		fclose(csv);
+	return 0;
+}
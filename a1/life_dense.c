@@ -0,0 +1,133 @@
+/*
+ * Reference engine: the original int ** loop, one int per cell.
+ * Rules other than Conway's go through a [self][nbrs] lookup table.
+ * On a torus the arrays are N+2 wide with the board at offset 1, and the
+ * ghost border is copied in from the opposite edges before every step.
+ * As the reference for -S it counts in a separate, obviously right pass.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+
+struct dense_ctx {
+	int N;
+	int M;				//allocated size: N, or N+2 on a torus
+	int torus;
+	int stats;
+	struct life_stats * series;	//per generation of the last step, with -S
+	int series_len;
+	int ** current, ** previous;	//arrays - one for current timestep, one for previous timestep
+	int conway;			//rule is B3/S23
+	int next[2][9];			//next state by [self][nbrs] for other rules
+};
+
+static void * dense_init(int ** board, const struct life_params * p) {
+	struct dense_ctx * c = calloc(1, sizeof(*c));
+	int n, i;
+
+	c->N = p->N;
+	c->torus = p->torus;
+	c->stats = p->stats;
+	c->M = c->torus ? c->N+2 : c->N;
+	c->conway = RULE_IS(&p->rule, 0x008, 0x00c);
+	for ( n = 0 ; n <= 8 ; n++ ) {
+		c->next[0][n] = p->rule.birth >> n & 1;
+		c->next[1][n] = p->rule.survive >> n & 1;
+	}
+	c->current = allocate_array(c->M);
+	c->previous = allocate_array(c->M);
+	if ( c->torus )
+		for ( i = 0 ; i < c->N ; i++ )
+			memcpy(c->previous[i+1] + 1, board[i], c->N * sizeof(int));
+	else
+		copy_array(c->previous, board, c->N);
+	return c;
+}
+
+/* Copy the edges of the board at offset 1 into the ghost border of a */
+static void wrap(int ** a, int N) {
+	int i;
+
+	memcpy(a[0] + 1, a[N] + 1, N * sizeof(int));
+	memcpy(a[N+1] + 1, a[1] + 1, N * sizeof(int));
+	for ( i = 0 ; i <= N+1 ; i++ ) {
+		a[i][0] = a[i][N];
+		a[i][N+1] = a[i][1];
+	}
+}
+
+static void dense_step(void * ctx, int steps) {
+	struct dense_ctx * c = ctx;
+	int N = c->M;
+	int ** current = c->current, ** previous = c->previous;
+	int ** swap;			//array pointer
+	int t, i, j, nbrs;		//helper variables
+	struct life_stats * st;
+
+	if ( c->stats && steps > c->series_len ) {
+		c->series = realloc(c->series, steps * sizeof(struct life_stats));
+		c->series_len = steps;
+	}
+	for ( t = 0 ; t < steps ; t++ ) {
+		if ( c->torus )
+			wrap(previous, c->N);
+		for ( i = 1 ; i < N-1 ; i++ )
+			for ( j = 1 ; j < N-1 ; j++ ) {
+				nbrs = previous[i+1][j+1] + previous[i+1][j] + previous[i+1][j-1] \
+				       + previous[i][j-1] + previous[i][j+1] \
+				       + previous[i-1][j-1] + previous[i-1][j] + previous[i-1][j+1];
+				if ( !c->conway )
+					current[i][j]=c->next[previous[i][j]][nbrs];
+				else if ( nbrs == 3 || ( previous[i][j]+nbrs ==3 ) )
+					current[i][j]=1;
+				else
+					current[i][j]=0;
+			}
+		if ( c->stats ) {
+			st = &c->series[t];
+			st->population = st->births = st->deaths = 0;
+			for ( i = 1 ; i < N-1 ; i++ )
+				for ( j = 1 ; j < N-1 ; j++ ) {
+					st->population += current[i][j];
+					st->births += current[i][j] && !previous[i][j];
+					st->deaths += previous[i][j] && !current[i][j];
+				}
+		}
+
+		//Swap current array with previous array
+		swap=current;
+		current=previous;
+		previous=swap;
+	}
+	c->current = current;
+	c->previous = previous;
+}
+
+static void dense_get(void * ctx, int ** board) {
+	struct dense_ctx * c = ctx;
+	int i;
+
+	if ( c->torus )
+		for ( i = 0 ; i < c->N ; i++ )
+			memcpy(board[i], c->previous[i+1] + 1, c->N * sizeof(int));
+	else
+		copy_array(board, c->previous, c->N);
+}
+
+static const struct life_stats * dense_stats(void * ctx) {
+	struct dense_ctx * c = ctx;
+	return c->series;
+}
+
+static void dense_finalize(void * ctx) {
+	struct dense_ctx * c = ctx;
+	free(c->series);
+	free_array(c->current, c->M);
+	free_array(c->previous, c->M);
+	free(c);
+}
+
+const struct life_engine dense_engine = {
+	"dense", dense_init, dense_step, dense_get, dense_finalize, NULL, 1, 1, dense_stats
+};
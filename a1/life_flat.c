@@ -0,0 +1,217 @@
+/*
+ * Flat engine: the dense kernel on the contiguous byte-per-cell grid.
+ *
+ * One aligned allocation instead of N row mallocs, one byte per cell
+ * instead of an int, and rows addressed by a constant stride instead of a
+ * pointer load, so the compiler sees three unit-stride byte streams per
+ * output row and vectorizes the j loop. Rows are split statically over the
+ * OpenMP threads, matching the first touch in grid_alloc.
+ *
+ * The row loop is instantiated once per rule in KNOWN_RULES with the rule
+ * masks as constants, so each of them compiles to its own few compares.
+ * Other rules are a list of the cell states (nbrs + 16*self) that live on,
+ * or of those that die if that is shorter, so at most 9 of the 18. A cell
+ * compares its own state with each entry, without branches, and the row
+ * loop is instantiated for every list length, so the generic kernel
+ * vectorizes too and costs one compare per entry.
+ *
+ * On a torus the grid's ghost border is filled from the opposite edges
+ * before each generation, and the same kernel is handed the grid shifted
+ * by one row and column with size N+2, so it covers all N x N cells.
+ */
+
+#include <stdlib.h>
+#include "life.h"
+
+typedef void (*flat_kernel)(const unsigned char * prev, unsigned char * cur, ptrdiff_t S, int N,
+			    const unsigned char * next, struct life_stats * st);
+
+struct flat_ctx {
+	struct grid current, previous;
+	flat_kernel kernel;
+	int torus;
+	unsigned char next[10];		//generic kernel: states in the list, then 1 if they die
+	int entries;			//states in next
+	struct life_stats * series;	//per generation of the last step, with -S
+	int series_len;
+	long population;		//current population, with -S
+};
+
+/*
+ * Cells j0..j1-1 of a row. With stats set, their population and births are
+ * added to *bp and *bb in byte lanes, so at most 255 cells at a time.
+ */
+static inline __attribute__((always_inline))
+void flat_cells(const unsigned char * restrict up, const unsigned char * restrict mid,
+		const unsigned char * restrict dn, unsigned char * restrict out, int j0, int j1,
+		const unsigned char * list, int entries, unsigned char flip,
+		unsigned int birth, unsigned int survive, int stats, unsigned char * bp, unsigned char * bb) {
+	unsigned char nbrs, o, state, p = 0, b = 0;
+	int j, n;
+
+	for ( j = j0 ; j < j1 ; j++ ) {
+		nbrs = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + dn[j-1] + dn[j] + dn[j+1];
+		if ( entries >= 0 ) {
+			state = nbrs + 16*mid[j];
+			o = flip;
+			for ( n = 0 ; n < entries ; n++ )
+				o ^= state == list[n];
+		}
+		else
+			o = rule_cell(nbrs, mid[j], birth, survive);
+		out[j] = o;
+		if ( stats ) {
+			p += o;
+			b += o & ~mid[j];
+		}
+	}
+	*bp = p;
+	*bb = b;
+}
+
+/*
+ * Row i of one generation, prev -> cur. With stats set, the row's
+ * population and births are summed in the same pass, in blocks of a
+ * constant 240 cells (15 vectors) so the sums vectorize without widening
+ * and each block is a fixed trip count without a scalar epilogue.
+ */
+static inline __attribute__((always_inline))
+void flat_row(const unsigned char * restrict prev, unsigned char * restrict cur, ptrdiff_t S, int N, int i,
+	      const unsigned char * next, int entries, unsigned int birth, unsigned int survive,
+	      int stats, long * pop, long * born) {
+	const unsigned char * up = prev + (i-1)*S;
+	const unsigned char * mid = prev + i*S;
+	const unsigned char * dn = prev + (i+1)*S;
+	unsigned char * out = cur + i*S;
+	unsigned char bp, bb, list[9], flip = entries >= 0 ? next[9] : 0;
+	long p = 0, b = 0;
+	int j0 = 1, n;
+
+	for ( n = 0 ; n < entries ; n++ )	//locals, so the compares below see loop invariants
+		list[n] = next[n];
+
+	if ( stats ) {
+		for ( ; j0 + 240 <= N-1 ; j0 += 240 ) {
+			flat_cells(up, mid, dn, out, j0, j0 + 240, list, entries, flip, birth, survive, 1, &bp, &bb);
+			p += bp;
+			b += bb;
+		}
+	}
+	flat_cells(up, mid, dn, out, j0, N-1, list, entries, flip, birth, survive, stats, &bp, &bb);
+	if ( stats ) {
+		*pop += p + bp;
+		*born += b + bb;
+	}
+}
+
+/*
+ * flat_<name> and flat_<name>_stats for every known rule, plus
+ * flat_generic<k> for rules whose state list has k entries. The rule must be spelled out inside the
+ * parallel loop to reach the outlined body as constants. Statistics are
+ * accumulated per thread and reduced once at the end of the loop; deaths
+ * follow from the previous population, which st holds on entry.
+ */
+#define FLAT_KERNELS(name, entries, birth, survive) \
+static void flat_##name(const unsigned char * prev, unsigned char * cur, ptrdiff_t S, int N, \
+			const unsigned char * next, struct life_stats * st) { \
+	int i; \
+	_Pragma("omp parallel for schedule(static)") \
+	for ( i = 1 ; i < N-1 ; i++ ) \
+		flat_row(prev, cur, S, N, i, next, entries, birth, survive, 0, NULL, NULL); \
+} \
+static void flat_##name##_stats(const unsigned char * prev, unsigned char * cur, ptrdiff_t S, int N, \
+				const unsigned char * next, struct life_stats * st) { \
+	long pop = 0, born = 0; \
+	int i; \
+	_Pragma("omp parallel for schedule(static) reduction(+:pop,born)") \
+	for ( i = 1 ; i < N-1 ; i++ ) \
+		flat_row(prev, cur, S, N, i, next, entries, birth, survive, 1, &pop, &born); \
+	st->deaths = st->population + born - pop; \
+	st->population = pop; \
+	st->births = born; \
+}
+#define FLAT_KERNEL(name, bs, birth, survive)	FLAT_KERNELS(name, -1, birth, survive)
+KNOWN_RULES(FLAT_KERNEL)
+FLAT_KERNELS(generic0, 0, 0, 0) FLAT_KERNELS(generic1, 1, 0, 0) FLAT_KERNELS(generic2, 2, 0, 0)
+FLAT_KERNELS(generic3, 3, 0, 0) FLAT_KERNELS(generic4, 4, 0, 0) FLAT_KERNELS(generic5, 5, 0, 0)
+FLAT_KERNELS(generic6, 6, 0, 0) FLAT_KERNELS(generic7, 7, 0, 0) FLAT_KERNELS(generic8, 8, 0, 0)
+FLAT_KERNELS(generic9, 9, 0, 0)
+
+static const flat_kernel generic_kernels[10][2] = {
+#define G(k)	{ flat_generic##k, flat_generic##k##_stats },
+	G(0) G(1) G(2) G(3) G(4) G(5) G(6) G(7) G(8) G(9)
+#undef G
+};
+
+static void * flat_init(int ** board, const struct life_params * p) {
+	struct flat_ctx * c = calloc(1, sizeof(*c));
+	int n;
+
+	c->torus = p->torus;
+	c->next[9] = __builtin_popcount(p->rule.birth) + __builtin_popcount(p->rule.survive) > 9;
+	for ( n = 0 ; n <= 8 ; n++ ) {
+		if ( (p->rule.birth >> n & 1) != c->next[9] )
+			c->next[c->entries++] = n;
+		if ( (p->rule.survive >> n & 1) != c->next[9] )
+			c->next[c->entries++] = 16 + n;
+	}
+	c->kernel = generic_kernels[c->entries][p->stats != 0];
+#define X(name, bs, birth, survive) \
+	if ( RULE_IS(&p->rule, birth, survive) ) \
+		c->kernel = p->stats ? flat_##name##_stats : flat_##name;
+	KNOWN_RULES(X)
+#undef X
+
+	grid_alloc(&c->current, p->N);
+	grid_alloc(&c->previous, p->N);
+	grid_load(&c->previous, board);
+	c->population = board_population(board, p->N);
+	return c;
+}
+
+static void flat_step(void * ctx, int steps) {
+	struct flat_ctx * c = ctx;
+	ptrdiff_t S = c->current.stride, off = c->torus ? -S-1 : 0;
+	int M = c->torus ? c->current.N+2 : c->current.N;
+	struct grid swap;
+	int t;
+
+	if ( steps > c->series_len ) {
+		c->series = realloc(c->series, steps * sizeof(struct life_stats));
+		c->series_len = steps;
+	}
+	for ( t = 0 ; t < steps ; t++ ) {
+		if ( c->torus )
+			grid_wrap(&c->previous);
+		c->series[t].population = t ? c->series[t-1].population : c->population;
+		c->kernel(c->previous.cells + off, c->current.cells + off, S, M, c->next, &c->series[t]);
+
+		swap = c->current;
+		c->current = c->previous;
+		c->previous = swap;
+	}
+	if ( steps > 0 )
+		c->population = c->series[steps-1].population;
+}
+
+static void flat_get(void * ctx, int ** board) {
+	struct flat_ctx * c = ctx;
+	grid_store(&c->previous, board);
+}
+
+static const struct life_stats * flat_stats(void * ctx) {
+	struct flat_ctx * c = ctx;
+	return c->series;
+}
+
+static void flat_finalize(void * ctx) {
+	struct flat_ctx * c = ctx;
+	free(c->series);
+	grid_free(&c->current);
+	grid_free(&c->previous);
+	free(c);
+}
+
+const struct life_engine flat_engine = {
+	"flat", flat_init, flat_step, flat_get, flat_finalize, NULL, 1, 1, flat_stats
+};
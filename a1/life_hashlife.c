@@ -0,0 +1,401 @@
+/*
+ * Hashlife engine: hash-consed quadtree with memoized futures.
+ *
+ * A level-k node is a 2^k x 2^k square made of four level k-1 children;
+ * identical squares are the same node (hash-consing), so repeated and empty
+ * regions cost one node each. successor(n, j) returns the level k-1 centre
+ * of n advanced 2^j generations (j <= k-2) and is memoized on the node, so
+ * any square seen before is advanced in O(1).
+ *
+ * The dense engines keep rows/columns 0 and N-1 dead forever. That is not a
+ * plain Life universe, but it is one of a translation-invariant automaton
+ * with a third, inert "wall" state that counts as dead: the frame is made of
+ * walls and everything outside it is dead and stays so. Hashlife works for
+ * any such automaton, so results match the dense engines bit for bit.
+ * The same holds for any B/S rule without B0, under which empty space
+ * would not stay empty.
+ *
+ * The board sits at the origin of a level-K root (2^K >= N). Advancing by
+ * 2^j pads the root with empty space until it is at least level j+2, takes
+ * the successor and crops the padding back off. T is advanced one set bit
+ * at a time, so T = 2^k costs a single jump.
+ *
+ * Nodes come from a pool bounded by -m (MB). When a jump leaves more nodes
+ * than that, a mark-and-sweep from the root frees everything unreachable,
+ * first keeping the memoized results of live nodes and, if that is not
+ * enough, dropping all of them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "life.h"
+
+#define DEAD	0
+#define ALIVE	1
+#define WALL	2
+
+#define MAX_LEVEL	64
+#define SLAB_NODES	65536
+
+struct node {
+	struct node * nw, * ne, * sw, * se;	//children, NULL for leaves
+	struct node * result;			//memoized successor(this, result_j)
+	struct node * next;			//hash chain
+	int level;
+	short result_j;
+	unsigned char mark;
+	unsigned char state;			//leaves only
+};
+
+struct slab {
+	struct slab * next;
+	struct node nodes[SLAB_NODES];
+};
+
+struct hl_ctx {
+	int N;
+	int K;				//root level
+	struct node * root;
+	struct node leaves[3];		//DEAD, ALIVE, WALL
+	struct node * empty[MAX_LEVEL];	//all-dead node of every level, built on demand
+	struct node ** table;		//hash buckets
+	size_t nbuckets;
+	size_t count;			//nodes in the table
+	size_t max_nodes;		//GC threshold
+	size_t peak;
+	struct node * free_list;
+	struct slab * slabs;
+	size_t slab_used;		//nodes handed out from slabs->nodes
+	int gcs;			//GC runs
+	unsigned int next[2];		//rule: birth, survive masks
+};
+
+static size_t hash4(const struct node * a, const struct node * b, const struct node * c, const struct node * d) {
+	uint64_t h = (uintptr_t)a >> 4;
+	h = h * 0x9E3779B97F4A7C15ULL + ((uintptr_t)b >> 4);
+	h = h * 0x9E3779B97F4A7C15ULL + ((uintptr_t)c >> 4);
+	h = h * 0x9E3779B97F4A7C15ULL + ((uintptr_t)d >> 4);
+	return (size_t)(h ^ (h >> 29));
+}
+
+static void rehash(struct hl_ctx * c, size_t nbuckets) {
+	struct node ** table = calloc(nbuckets, sizeof(struct node *));
+	struct node * n, * next;
+	size_t i, h;
+
+	for ( i = 0 ; i < c->nbuckets ; i++ )
+		for ( n = c->table[i] ; n ; n = next ) {
+			next = n->next;
+			h = hash4(n->nw, n->ne, n->sw, n->se) & (nbuckets-1);
+			n->next = table[h];
+			table[h] = n;
+		}
+	free(c->table);
+	c->table = table;
+	c->nbuckets = nbuckets;
+}
+
+static struct node * new_node(struct hl_ctx * c) {
+	struct node * n;
+	struct slab * s;
+
+	if ( c->free_list ) {
+		n = c->free_list;
+		c->free_list = n->next;
+		return n;
+	}
+	if ( !c->slabs || c->slab_used == SLAB_NODES ) {
+		s = malloc(sizeof(*s));
+		if ( !s ) {
+			fprintf(stderr, "hashlife: out of memory\n");
+			exit(1);
+		}
+		s->next = c->slabs;
+		c->slabs = s;
+		c->slab_used = 0;
+	}
+	return &c->slabs->nodes[c->slab_used++];
+}
+
+/* The unique node with these four children */
+static struct node * join(struct hl_ctx * c, struct node * nw, struct node * ne, struct node * sw, struct node * se) {
+	size_t h = hash4(nw, ne, sw, se) & (c->nbuckets-1);
+	struct node * n;
+
+	for ( n = c->table[h] ; n ; n = n->next )
+		if ( n->nw == nw && n->ne == ne && n->sw == sw && n->se == se )
+			return n;
+
+	n = new_node(c);
+	n->nw = nw; n->ne = ne; n->sw = sw; n->se = se;
+	n->result = NULL;
+	n->result_j = -1;
+	n->level = nw->level + 1;
+	n->mark = 0;
+	n->state = DEAD;
+	n->next = c->table[h];
+	c->table[h] = n;
+	if ( ++c->count > c->peak )
+		c->peak = c->count;
+	if ( c->count > 2*c->nbuckets )
+		rehash(c, 2*c->nbuckets);
+	return n;
+}
+
+static struct node * empty(struct hl_ctx * c, int level) {
+	if ( !c->empty[level] )
+		c->empty[level] = level == 0 ? &c->leaves[DEAD] :
+			join(c, empty(c, level-1), empty(c, level-1), empty(c, level-1), empty(c, level-1));
+	return c->empty[level];
+}
+
+/* n padded with empty space to the next level, n in the centre */
+static struct node * expand(struct hl_ctx * c, struct node * n) {
+	struct node * e = empty(c, n->level-1);
+	return join(c, join(c, e, e, e, n->nw), join(c, e, e, n->ne, e),
+		       join(c, e, n->sw, e, e), join(c, n->se, e, e, e));
+}
+
+/* The centre of n, one level down (inverse of expand) */
+static struct node * centre(struct hl_ctx * c, struct node * n) {
+	return join(c, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+/* One generation of the centre 2x2 of a 4x4 node */
+static struct node * life_4x4(struct hl_ctx * c, struct node * n) {
+	unsigned char g[4][4];
+	struct node * q[4] = { n->nw, n->ne, n->sw, n->se };
+	struct node * r[4];
+	int k, i, j, di, dj, nbrs;
+
+	for ( k = 0 ; k < 4 ; k++ ) {
+		int oi = (k/2)*2, oj = (k%2)*2;
+		g[oi][oj] = q[k]->nw->state;
+		g[oi][oj+1] = q[k]->ne->state;
+		g[oi+1][oj] = q[k]->sw->state;
+		g[oi+1][oj+1] = q[k]->se->state;
+	}
+	for ( k = 0 ; k < 4 ; k++ ) {
+		i = 1 + k/2;
+		j = 1 + k%2;
+		if ( g[i][j] == WALL ) {
+			r[k] = &c->leaves[WALL];
+			continue;
+		}
+		nbrs = 0;
+		for ( di = -1 ; di <= 1 ; di++ )
+			for ( dj = -1 ; dj <= 1 ; dj++ )
+				if ( (di || dj) && g[i+di][j+dj] == ALIVE )
+					nbrs++;
+		r[k] = &c->leaves[c->next[g[i][j]] >> nbrs & 1 ? ALIVE : DEAD];
+	}
+	return join(c, r[0], r[1], r[2], r[3]);
+}
+
+/*
+ * Centre of n (level k) advanced 2^j generations. A level k node can only
+ * jump 2^(k-2), so a larger j is clamped first and the memo holds the
+ * jump actually made, whatever the caller asked for.
+ */
+static struct node * successor(struct hl_ctx * c, struct node * n, int j) {
+	struct node * c1, * c2, * c3, * c4, * c5, * c6, * c7, * c8, * c9, * s;
+	int k = n->level;
+
+	if ( j > k-2 )
+		j = k-2;
+	if ( n->result && n->result_j == j )
+		return n->result;
+	if ( n == c->empty[k] )
+		return empty(c, k-1);
+
+	if ( k == 2 )
+		s = life_4x4(c, n);
+	else {
+		c1 = successor(c, n->nw, j);
+		c2 = successor(c, join(c, n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw), j);
+		c3 = successor(c, n->ne, j);
+		c4 = successor(c, join(c, n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne), j);
+		c5 = successor(c, join(c, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw), j);
+		c6 = successor(c, join(c, n->ne->sw, n->ne->se, n->se->nw, n->se->ne), j);
+		c7 = successor(c, n->sw, j);
+		c8 = successor(c, join(c, n->sw->ne, n->se->nw, n->sw->se, n->se->sw), j);
+		c9 = successor(c, n->se, j);
+		if ( j < k-2 )
+			s = join(c, join(c, c1->se, c2->sw, c4->ne, c5->nw),
+				    join(c, c2->se, c3->sw, c5->ne, c6->nw),
+				    join(c, c4->se, c5->sw, c7->ne, c8->nw),
+				    join(c, c5->se, c6->sw, c8->ne, c9->nw));
+		else
+			s = join(c, successor(c, join(c, c1, c2, c4, c5), j),
+				    successor(c, join(c, c2, c3, c5, c6), j),
+				    successor(c, join(c, c4, c5, c7, c8), j),
+				    successor(c, join(c, c5, c6, c8, c9), j));
+	}
+	n->result = s;
+	n->result_j = j;
+	return s;
+}
+
+static void mark(struct node * n, int results) {
+	while ( n && n->level > 0 && !n->mark ) {
+		n->mark = 1;
+		mark(n->nw, results);
+		mark(n->ne, results);
+		mark(n->sw, results);
+		if ( results )
+			mark(n->result, results);
+		n = n->se;
+	}
+}
+
+static void sweep(struct hl_ctx * c) {
+	struct node ** p, * n;
+	size_t i;
+
+	for ( i = 0 ; i < c->nbuckets ; i++ )
+		for ( p = &c->table[i] ; (n = *p) ; )
+			if ( n->mark ) {
+				n->mark = 0;
+				p = &n->next;
+			}
+			else {
+				*p = n->next;
+				n->next = c->free_list;
+				c->free_list = n;
+				c->count--;
+			}
+}
+
+static void collect(struct hl_ctx * c, int results) {
+	struct node * n;
+	size_t i;
+	int l;
+
+	if ( !results )
+		for ( i = 0 ; i < c->nbuckets ; i++ )
+			for ( n = c->table[i] ; n ; n = n->next )
+				n->result = NULL;
+	mark(c->root, results);
+	for ( l = 0 ; l < MAX_LEVEL ; l++ )
+		mark(c->empty[l], results);
+	sweep(c);
+	c->gcs++;
+}
+
+static void gc(struct hl_ctx * c) {
+	if ( c->count <= c->max_nodes )
+		return;
+	collect(c, 1);
+	if ( c->count > c->max_nodes / 2 )
+		collect(c, 0);
+}
+
+/* Level `level` node for the square at (r, c0) of the dense board */
+static struct node * build(struct hl_ctx * c, int ** board, int level, int r, int c0) {
+	int N = c->N, h = 1 << level >> 1;
+
+	if ( r >= N || c0 >= N )
+		return empty(c, level);
+	if ( level == 0 ) {
+		if ( r == 0 || c0 == 0 || r == N-1 || c0 == N-1 )
+			return &c->leaves[WALL];
+		return &c->leaves[board[r][c0] ? ALIVE : DEAD];
+	}
+	return join(c, build(c, board, level-1, r, c0), build(c, board, level-1, r, c0+h),
+		       build(c, board, level-1, r+h, c0), build(c, board, level-1, r+h, c0+h));
+}
+
+static void flatten(struct hl_ctx * c, struct node * n, int ** board, int r, int c0) {
+	int N = c->N, h = 1 << n->level >> 1;
+
+	if ( r >= N || c0 >= N || n == c->empty[n->level] )
+		return;
+	if ( n->level == 0 ) {
+		board[r][c0] = n->state == ALIVE;
+		return;
+	}
+	flatten(c, n->nw, board, r, c0);
+	flatten(c, n->ne, board, r, c0+h);
+	flatten(c, n->sw, board, r+h, c0);
+	flatten(c, n->se, board, r+h, c0+h);
+}
+
+static void * hl_init(int ** board, const struct life_params * p) {
+	struct hl_ctx * c = calloc(1, sizeof(*c));
+	int s;
+
+	if ( p->rule.birth & 1 ) {
+		fprintf(stderr, "hashlife: rule %s has B0, empty space would not stay empty\n", p->rule.name);
+		exit(1);
+	}
+	c->N = p->N;
+	c->next[DEAD] = p->rule.birth;
+	c->next[ALIVE] = p->rule.survive;
+	for ( c->K = 2 ; (1 << c->K) < c->N ; c->K++ ) ;
+	for ( s = DEAD ; s <= WALL ; s++ ) {
+		c->leaves[s].level = 0;
+		c->leaves[s].state = s;
+	}
+	c->nbuckets = 1 << 16;
+	c->table = calloc(c->nbuckets, sizeof(struct node *));
+	c->max_nodes = (size_t)p->cache_mb * 1024 * 1024 / sizeof(struct node);
+	c->root = build(c, board, c->K, 0, 0);
+	return c;
+}
+
+/* Advance the root by 2^j generations */
+static void jump(struct hl_ctx * c, int j) {
+	struct node * n = expand(c, c->root);
+	int m = 1;
+
+	while ( n->level - 2 < j ) {
+		n = expand(c, n);
+		m++;
+	}
+	n = successor(c, n, j);
+	while ( --m )
+		n = centre(c, n);
+	c->root = n;
+	gc(c);
+}
+
+static void hl_step(void * ctx, int steps) {
+	struct hl_ctx * c = ctx;
+	int j;
+
+	for ( j = 0 ; steps ; j++, steps >>= 1 )
+		if ( steps & 1 )
+			jump(c, j);
+}
+
+static void hl_get(void * ctx, int ** board) {
+	struct hl_ctx * c = ctx;
+	int i, j;
+
+	for ( i = 0 ; i < c->N ; i++ )
+		for ( j = 0 ; j < c->N ; j++ )
+			board[i][j] = 0;
+	flatten(c, c->root, board, 0, 0);
+}
+
+static void hl_report(void * ctx) {
+	struct hl_ctx * c = ctx;
+	printf("Nodes %zu PeakNodes %zu MaxNodes %zu GCs %d\n", c->count, c->peak, c->max_nodes, c->gcs);
+}
+
+static void hl_finalize(void * ctx) {
+	struct hl_ctx * c = ctx;
+	struct slab * s, * next;
+
+	for ( s = c->slabs ; s ; s = next ) {
+		next = s->next;
+		free(s);
+	}
+	free(c->table);
+	free(c);
+}
+
+const struct life_engine hashlife_engine = {
+	"hashlife", hl_init, hl_step, hl_get, hl_finalize, hl_report, 1
+};
@@ -0,0 +1,297 @@
+/******************************************************
+ ******** Conway's game of life - MPI version *********
+ ******************************************************
+
+ Usage: mpirun -np Px*Py ./life_mpi [-s seed] [-t] [-c] ArraySize TimeSteps Px Py
+
+ The board is split over a Px x Py cartesian process
+ grid (padded if ArraySize does not divide evenly).
+ Every process generates its own block of the random
+ board (random_cell depends only on seed and position)
+ and keeps it as byte cells with one ghost row/column
+ on each side. Each generation it
+ posts non-blocking sends/receives for its 8 halo
+ pieces (4 edges, 4 corners), updates the cells that
+ do not touch a ghost while they are in flight, and
+ finishes the outer ring of its block once they land.
+
+ -t makes the board a torus: the process grid is periodic,
+    so the wrap-around is just more halo exchange (Px and
+    Py must then divide ArraySize).
+
+ -c gathers the final board on rank 0 and compares it
+    with the serial dense engine run on the same start.
+
+ Build with: make life_mpi
+ ******************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "mpi.h"
+#include "life.h"
+
+enum { NORTH, SOUTH, WEST, EAST, NW, NE, SW, SE, NDIRS };
+
+static const int di[NDIRS] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+static const int dj[NDIRS] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+static const int opposite[NDIRS] = { SOUTH, NORTH, EAST, WEST, SE, SW, NE, NW };
+
+/* Update rows [i0,i1] x columns [j0,j1] (inclusive) of a block with row stride W */
+static void update(const unsigned char * prev, unsigned char * cur, int W, int i0, int i1, int j0, int j1) {
+	unsigned char nbrs;
+	int i, j;
+
+	for ( i = i0 ; i <= i1 ; i++ ) {
+		const unsigned char * up = prev + (i-1)*W, * mid = prev + i*W, * dn = prev + (i+1)*W;
+		unsigned char * out = cur + i*W;
+		for ( j = j0 ; j <= j1 ; j++ ) {
+			nbrs = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + dn[j-1] + dn[j] + dn[j+1];
+			out[j] = ( nbrs | mid[j] ) == 3;
+		}
+	}
+}
+
+int main(int argc, char ** argv) {
+	int rank, size;
+	int N, T;				//global board size, time steps
+	int grid[2];				//processor grid dimensions
+	int local[2];				//local block dimensions (without ghosts)
+	int W;					//local row stride (local[1]+2)
+	int nbr[NDIRS];				//neighbour ranks, MPI_PROC_NULL off the grid
+	int i_min, i_max, j_min, j_max;		//cells of the block that are updated
+	int i, j, t, d, opt, check = 0, torus = 0;
+	unsigned int seed = 1;
+	unsigned char * current, * previous, * swap, * packed = NULL, * block;
+	int ** board = NULL, ** reference;
+
+	struct timeval tts, ttf, tcs, tcf;	//Timers: total-> tts,ttf, computation -> tcs,tcf
+	double ttotal = 0, tcomp = 0, total_time, comp_time;
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	while ( (opt = getopt(argc, argv, "s:tc")) != -1 ) {
+		switch (opt) {
+			case 's':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			case 't':
+				torus = 1;
+				break;
+			case 'c':
+				check = 1;
+				break;
+			default:
+				argc = 0;
+		}
+	}
+	if ( argc - optind != 4 ) {
+		if ( rank == 0 )
+			fprintf(stderr, "Usage: mpirun .... ./life_mpi [-s seed] [-t] [-c] ArraySize TimeSteps Px Py\n");
+		MPI_Finalize();
+		exit(-1);
+	}
+	N = atoi(argv[optind]);
+	T = atoi(argv[optind+1]);
+	grid[0] = atoi(argv[optind+2]);
+	grid[1] = atoi(argv[optind+3]);
+	if ( grid[0]*grid[1] != size ) {
+		if ( rank == 0 )
+			fprintf(stderr, "Px*Py (%d) must equal the number of processes (%d)\n", grid[0]*grid[1], size);
+		MPI_Finalize();
+		exit(-1);
+	}
+	if ( torus && ( N % grid[0] || N % grid[1] ) ) {
+		if ( rank == 0 )
+			fprintf(stderr, "-t needs Px and Py to divide ArraySize (%d)\n", N);
+		MPI_Finalize();
+		exit(-1);
+	}
+
+	//----Create 2D-cartesian communicator----//
+
+	MPI_Comm CART_COMM;
+	int periods[2] = { torus, torus };
+	int rank_grid[2], coords[2];
+
+	MPI_Cart_create(MPI_COMM_WORLD, 2, grid, periods, 0, &CART_COMM);
+	MPI_Comm_rank(CART_COMM, &rank);
+	MPI_Cart_coords(CART_COMM, rank, 2, rank_grid);
+
+	for ( d = 0 ; d < NDIRS ; d++ ) {
+		coords[0] = rank_grid[0] + di[d];
+		coords[1] = rank_grid[1] + dj[d];
+		if ( !torus && ( coords[0] < 0 || coords[0] >= grid[0] || coords[1] < 0 || coords[1] >= grid[1] ) )
+			nbr[d] = MPI_PROC_NULL;
+		else
+			MPI_Cart_rank(CART_COMM, coords, &nbr[d]);	//wraps on a torus
+	}
+
+	//----Local block dimensions; pad the board if it does not divide evenly----//
+
+	for ( i = 0 ; i < 2 ; i++ )
+		local[i] = (N + grid[i] - 1) / grid[i];
+	W = local[1] + 2;
+
+	//----Only cells 1..N-2 of the global board are ever updated----//
+	//----(dead frame and padding stay 0); on a torus all of them----//
+
+	i_min = 1; i_max = local[0];
+	j_min = 1; j_max = local[1];
+	if ( !torus ) {
+		if ( rank_grid[0]*local[0] + i_min-1 < 1 ) i_min = 1 - rank_grid[0]*local[0] + 1;
+		if ( rank_grid[0]*local[0] + i_max-1 > N-2 ) i_max = N-2 - rank_grid[0]*local[0] + 1;
+		if ( rank_grid[1]*local[1] + j_min-1 < 1 ) j_min = 1 - rank_grid[1]*local[1] + 1;
+		if ( rank_grid[1]*local[1] + j_max-1 > N-2 ) j_max = N-2 - rank_grid[1]*local[1] + 1;
+	}
+
+	current = calloc((size_t)(local[0]+2) * W, 1);
+	previous = calloc((size_t)(local[0]+2) * W, 1);
+	block = malloc((size_t)local[0] * local[1]);
+
+	//----Every rank fills its own block: the random board is a----//
+	//----function of (seed, i, j), so nothing is scattered----//
+
+	#pragma omp parallel for schedule(static) private(j)
+	for ( i = 0 ; i < local[0] ; i++ )
+		for ( j = 0 ; j < local[1] ; j++ ) {
+			int gi = rank_grid[0]*local[0] + i, gj = rank_grid[1]*local[1] + j;
+			if ( gi >= 1 && gi <= N-2 && gj >= 1 && gj <= N-2 )
+				previous[(i+1)*W + j+1] = random_cell(seed, gi, gj);
+		}
+
+	//----Halo datatypes: a row, a column, a single corner cell----//
+
+	MPI_Datatype row, column, halo[NDIRS];
+	int send_at[NDIRS], recv_at[NDIRS];	//offsets of the piece sent towards d / received from d
+
+	MPI_Type_contiguous(local[1], MPI_BYTE, &row);
+	MPI_Type_commit(&row);
+	MPI_Type_vector(local[0], 1, W, MPI_BYTE, &column);
+	MPI_Type_commit(&column);
+
+	halo[NORTH] = halo[SOUTH] = row;
+	halo[WEST] = halo[EAST] = column;
+	halo[NW] = halo[NE] = halo[SW] = halo[SE] = MPI_BYTE;
+
+	send_at[NORTH] = 1*W + 1;		recv_at[NORTH] = 0*W + 1;
+	send_at[SOUTH] = local[0]*W + 1;	recv_at[SOUTH] = (local[0]+1)*W + 1;
+	send_at[WEST] = 1*W + 1;		recv_at[WEST] = 1*W + 0;
+	send_at[EAST] = 1*W + local[1];		recv_at[EAST] = 1*W + local[1]+1;
+	send_at[NW] = 1*W + 1;			recv_at[NW] = 0;
+	send_at[NE] = 1*W + local[1];		recv_at[NE] = local[1]+1;
+	send_at[SW] = local[0]*W + 1;		recv_at[SW] = (local[0]+1)*W;
+	send_at[SE] = local[0]*W + local[1];	recv_at[SE] = (local[0]+1)*W + local[1]+1;
+
+	//----Computational core----//
+
+	MPI_Request req[2*NDIRS];
+	int in_lo = i_min > 2 ? i_min : 2, in_hi = i_max < local[0]-1 ? i_max : local[0]-1;
+	int jn_lo = j_min > 2 ? j_min : 2, jn_hi = j_max < local[1]-1 ? j_max : local[1]-1;
+
+	gettimeofday(&tts, NULL);
+	for ( t = 0 ; t < T ; t++ ) {
+		//a message travelling in direction d carries tag d
+		for ( d = 0 ; d < NDIRS ; d++ ) {
+			MPI_Irecv(previous + recv_at[d], 1, halo[d], nbr[d], opposite[d], CART_COMM, &req[d]);
+			MPI_Isend(previous + send_at[d], 1, halo[d], nbr[d], d, CART_COMM, &req[NDIRS+d]);
+		}
+
+		gettimeofday(&tcs, NULL);
+		//inner cells do not read any ghost
+		update(previous, current, W, in_lo, in_hi, jn_lo, jn_hi);
+		gettimeofday(&tcf, NULL);
+		tcomp += (tcf.tv_sec-tcs.tv_sec)+(tcf.tv_usec-tcs.tv_usec)*0.000001;
+
+		MPI_Waitall(2*NDIRS, req, MPI_STATUSES_IGNORE);
+
+		gettimeofday(&tcs, NULL);
+		//outer ring of the block: first/last row, then first/last column
+		if ( i_min <= 1 && i_max >= 1 )
+			update(previous, current, W, 1, 1, j_min, j_max);
+		if ( i_min <= local[0] && i_max >= local[0] && local[0] > 1 )
+			update(previous, current, W, local[0], local[0], j_min, j_max);
+		if ( j_min <= 1 && j_max >= 1 )
+			update(previous, current, W, in_lo, in_hi, 1, 1);
+		if ( j_min <= local[1] && j_max >= local[1] && local[1] > 1 )
+			update(previous, current, W, in_lo, in_hi, local[1], local[1]);
+		gettimeofday(&tcf, NULL);
+		tcomp += (tcf.tv_sec-tcs.tv_sec)+(tcf.tv_usec-tcs.tv_usec)*0.000001;
+
+		swap = current;
+		current = previous;
+		previous = swap;
+	}
+	gettimeofday(&ttf, NULL);
+
+	ttotal = (ttf.tv_sec-tts.tv_sec)+(ttf.tv_usec-tts.tv_usec)*0.000001;
+
+	MPI_Reduce(&ttotal, &total_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&tcomp, &comp_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	if ( rank == 0 )
+		printf("GameOfLifeMPI: Size %d Steps %d Px %d Py %d ComputationTime %lf TotalTime %lf\n",
+		       N, T, grid[0], grid[1], comp_time, total_time);
+
+	//----Rank 0 gathers the blocks and compares with the serial engine----//
+
+	if ( check ) {
+		for ( i = 0 ; i < local[0] ; i++ )
+			memcpy(block + (size_t)i*local[1], previous + (i+1)*W + 1, local[1]);
+		if ( rank == 0 )
+			packed = malloc((size_t)size * local[0] * local[1]);
+		MPI_Gather(block, local[0]*local[1], MPI_BYTE, packed, local[0]*local[1], MPI_BYTE, 0, CART_COMM);
+
+		if ( rank == 0 ) {
+			struct life_params p = { 0 };
+			int bi, bj, r, diff;
+			void * ctx;
+
+			board = allocate_array(N);
+			init_random(board, N, seed);
+
+			p.N = N;
+			p.T = T;
+			p.torus = torus;
+			rule_parse("B3/S23", &p.rule);
+			reference = allocate_array(N);
+			ctx = dense_engine.init(board, &p);
+			dense_engine.step(ctx, T);
+			dense_engine.get(ctx, reference);
+			dense_engine.finalize(ctx);
+
+			for ( bi = 0 ; bi < grid[0] ; bi++ )
+				for ( bj = 0 ; bj < grid[1] ; bj++ ) {
+					coords[0] = bi;
+					coords[1] = bj;
+					MPI_Cart_rank(CART_COMM, coords, &r);
+					for ( i = 0 ; i < local[0] ; i++ )
+						for ( j = 0 ; j < local[1] ; j++ )
+							if ( bi*local[0]+i < N && bj*local[1]+j < N )
+								board[bi*local[0]+i][bj*local[1]+j] = packed[((size_t)r*local[0] + i)*local[1] + j];
+				}
+			diff = compare_array(board, reference, N);
+			if ( diff )
+				printf("Check: FAILED (%d cells differ from dense)\n", diff);
+			else
+				printf("Check: OK\n");
+			free_array(reference, N);
+		}
+	}
+
+	if ( rank == 0 && check ) {
+		free_array(board, N);
+		free(packed);
+	}
+	free(current);
+	free(previous);
+	free(block);
+	MPI_Type_free(&row);
+	MPI_Type_free(&column);
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * OpenMP engine: same int ** layout and kernel as the dense engine, but the
+ * interior rows are split into one contiguous band per thread.
+ *
+ * Each thread mallocs, zero-fills and copies in the rows of its own band,
+ * so under Linux' first-touch policy those pages land on the thread's NUMA
+ * node, and then only ever updates that same band. With -p every thread is
+ * pinned to a core first (thread i to cpu i, or to the i-th entry of the
+ * MT_CONF cpu list), otherwise the placement is only as good as the
+ * scheduler keeps it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "life.h"
+
+struct omp_ctx {
+	int N;
+	int nthreads;
+	int pin;
+	int ** current, ** previous;
+	int * lo, * hi;			//row band [lo, hi) owned by each thread
+	double * busy;			//time each thread spent computing its band
+};
+
+static void band(int N, int nthreads, int tid, int * lo, int * hi) {
+	int rows = N-2, chunk = rows / nthreads, rem = rows % nthreads;
+
+	*lo = 1 + tid*chunk + (tid < rem ? tid : rem);
+	*hi = *lo + chunk + (tid < rem ? 1 : 0);
+	//the dead frame rows go to the first and last thread
+	if ( tid == 0 ) *lo = 0;
+	if ( tid == nthreads-1 ) *hi = N;
+}
+
+static void * omp_init(int ** board, const struct life_params * p) {
+	struct omp_ctx * c = malloc(sizeof(*c));
+	int N = p->N;
+
+	c->N = N;
+	c->pin = p->pin;
+	c->nthreads = omp_get_max_threads();
+	if ( c->nthreads > N-2 )
+		c->nthreads = N-2 > 0 ? N-2 : 1;
+	c->current = malloc(N * sizeof(int*));
+	c->previous = malloc(N * sizeof(int*));
+	c->lo = malloc(c->nthreads * sizeof(int));
+	c->hi = malloc(c->nthreads * sizeof(int));
+	c->busy = calloc(c->nthreads, sizeof(double));
+
+	#pragma omp parallel num_threads(c->nthreads)
+	{
+		int tid = omp_get_thread_num(), i, j;
+
+		if ( c->pin )
+			pin_thread(tid);
+		band(N, c->nthreads, tid, &c->lo[tid], &c->hi[tid]);
+		for ( i = c->lo[tid] ; i < c->hi[tid] ; i++ ) {
+			c->current[i] = malloc(N * sizeof(int));
+			c->previous[i] = malloc(N * sizeof(int));
+			for ( j = 0 ; j < N ; j++ ) {
+				c->current[i][j] = 0;
+				c->previous[i][j] = board[i][j];
+			}
+		}
+	}
+	return c;
+}
+
+static void omp_step(void * ctx, int steps) {
+	struct omp_ctx * c = ctx;
+	int N = c->N;
+
+	#pragma omp parallel num_threads(c->nthreads)
+	{
+		int tid = omp_get_thread_num();
+		int lo = c->lo[tid] > 1 ? c->lo[tid] : 1;
+		int hi = c->hi[tid] < N-1 ? c->hi[tid] : N-1;
+		int ** current = c->current, ** previous = c->previous, ** swap;
+		int t, i, j, nbrs;
+		double ts;
+
+		if ( c->pin )
+			pin_thread(tid);
+		for ( t = 0 ; t < steps ; t++ ) {
+			ts = omp_get_wtime();
+			for ( i = lo ; i < hi ; i++ )
+				for ( j = 1 ; j < N-1 ; j++ ) {
+					nbrs = previous[i+1][j+1] + previous[i+1][j] + previous[i+1][j-1] \
+					       + previous[i][j-1] + previous[i][j+1] \
+					       + previous[i-1][j-1] + previous[i-1][j] + previous[i-1][j+1];
+					if ( nbrs == 3 || ( previous[i][j]+nbrs ==3 ) )
+						current[i][j]=1;
+					else
+						current[i][j]=0;
+				}
+			c->busy[tid] += omp_get_wtime() - ts;
+
+			swap=current;
+			current=previous;
+			previous=swap;
+			#pragma omp barrier
+		}
+		#pragma omp single
+		{
+			c->current = current;
+			c->previous = previous;
+		}
+	}
+}
+
+static void omp_get(void * ctx, int ** board) {
+	struct omp_ctx * c = ctx;
+	copy_array(board, c->previous, c->N);
+}
+
+static void omp_report(void * ctx) {
+	struct omp_ctx * c = ctx;
+	int tid;
+
+	for ( tid = 0 ; tid < c->nthreads ; tid++ )
+		printf("Thread %d Rows %d-%d Time %lf\n", tid, c->lo[tid], c->hi[tid]-1, c->busy[tid]);
+}
+
+static void omp_finalize(void * ctx) {
+	struct omp_ctx * c = ctx;
+	int i;
+
+	for ( i = 0 ; i < c->N ; i++ ) {
+		free(c->current[i]);
+		free(c->previous[i]);
+	}
+	free(c->current);
+	free(c->previous);
+	free(c->lo);
+	free(c->hi);
+	free(c->busy);
+	free(c);
+}
+
+const struct life_engine omp_engine = {
+	"omp", omp_init, omp_step, omp_get, omp_finalize, omp_report
+};
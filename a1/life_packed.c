@@ -0,0 +1,342 @@
+/*
+ * Bit-packed engine: 64 cells per uint64_t, bit b of word w holds column
+ * 64*(w-1)+b. Each row is stored with one zero word of padding on either
+ * side so the shifts that bring in the east/west neighbours never need a
+ * bounds check.
+ *
+ * The eight neighbours of all 64 cells of a word are summed with a
+ * bit-sliced adder (one full adder per neighbour row, then a small carry
+ * tree), giving the count as three bit-planes s2 s1 s0 (count mod 8). The
+ * rule "nbrs == 3 || self+nbrs == 3" is then s1 & ~s2 & (s0 | self); a
+ * count of 8 wraps to 0 and is correctly treated as dead.
+ *
+ * Other rules need the fourth plane s3 (the carry out of s2) and compare
+ * the four planes against every neighbour count in the rule's masks. The
+ * row loop is instantiated per rule in KNOWN_RULES, so those compares fold
+ * into a fixed expression; any other rule gets the masks at run time.
+ *
+ * There is one ghost row above and below the board. On a torus the ghost
+ * rows and the ghost bits either side of each row (bit 63 of the left
+ * padding word, the bit after column N-1) are copied from the opposite
+ * edges before every generation and the kernel runs over rows 0..N-1.
+ *
+ * With -S each row is counted (population and births; deaths follow from
+ * the previous population) right after it is computed, while it is still
+ * in L1, so the word loop itself stays the vectorized plain one. The count
+ * is a Harley-Seal carry-save adder over pairs of words: 8 pairs go into
+ * bit-sliced ones/twos/fours counters with 7 carry-save adds, and only
+ * the eights carry out is bit counted (SWAR, into byte lanes). The
+ * counters carry over from row to row and are counted once per
+ * generation. A popcount per word would serialize the loop, and the
+ * baseline x86-64 target has no POPCNT.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "life.h"
+
+typedef void (*packed_kernel)(const uint64_t * previous, uint64_t * current, const uint64_t * mask,
+			      int N, int W, int S, unsigned int birth, unsigned int survive,
+			      struct life_stats * st);
+
+struct packed_ctx {
+	int N;
+	struct life_rule rule;
+	packed_kernel kernel;
+	int W;				//data words per row
+	int S;				//row stride in words (W + 2 padding words)
+	int torus;
+	uint64_t * current, * previous;	//row 0, after one ghost row
+	uint64_t * mask;		//updated columns of each word: 1..N-2, or 0..N-1 on a torus
+	struct life_stats * series;	//per generation of the last step, with -S
+	int series_len;
+	long population;		//current population, with -S
+};
+
+/* Full adder on 64 independent lanes */
+#define FULL_ADD(s, c, a, b, d) \
+	do { \
+		uint64_t _x = (a) ^ (b); \
+		(s) = _x ^ (d); \
+		(c) = ((a) & (b)) | (_x & (d)); \
+	} while(0)
+
+static inline __attribute__((always_inline))
+uint64_t life_word(const uint64_t * up, const uint64_t * mid, const uint64_t * dn, int w,
+		   unsigned int birth, unsigned int survive) {
+	uint64_t uw = (up[w] << 1) | (up[w-1] >> 63), ue = (up[w] >> 1) | (up[w+1] << 63);
+	uint64_t mw = (mid[w] << 1) | (mid[w-1] >> 63), me = (mid[w] >> 1) | (mid[w+1] << 63);
+	uint64_t dw = (dn[w] << 1) | (dn[w-1] >> 63), de = (dn[w] >> 1) | (dn[w+1] << 63);
+	uint64_t us, uc, ds, dc, ms, mc;
+	uint64_t s0, k0, p, q, s1, s2, s3;
+	uint64_t born = 0, kept = 0, eq;
+
+	FULL_ADD(us, uc, uw, up[w], ue);	//row above: 0..3 as uc:us
+	FULL_ADD(ds, dc, dw, dn[w], de);	//row below
+	ms = mw ^ me;				//own row (centre excluded): 0..2 as mc:ms
+	mc = mw & me;
+
+	FULL_ADD(s0, k0, us, ds, ms);		//ones
+	FULL_ADD(p, q, uc, dc, mc);		//twos
+	s1 = p ^ k0;
+	s2 = q ^ (p & k0);
+
+	if ( birth == 0x008 && survive == 0x00c )
+		return s1 & ~s2 & (s0 | mid[w]);
+
+	s3 = q & p & k0;
+#define COUNT_IS(n) \
+	if ( (birth | survive) >> n & 1 ) { \
+		eq = (n & 1 ? s0 : ~s0) & (n & 2 ? s1 : ~s1) & (n & 4 ? s2 : ~s2) & (n & 8 ? s3 : ~s3); \
+		if ( birth >> n & 1 ) \
+			born |= eq; \
+		if ( survive >> n & 1 ) \
+			kept |= eq; \
+	}
+	COUNT_IS(0) COUNT_IS(1) COUNT_IS(2) COUNT_IS(3) COUNT_IS(4)
+	COUNT_IS(5) COUNT_IS(6) COUNT_IS(7) COUNT_IS(8)
+#undef COUNT_IS
+	return (born & ~mid[w]) | (kept & mid[w]);
+}
+
+/* Two words, as one SSE2 register */
+typedef uint64_t pair __attribute__((vector_size(16)));
+
+/* Number of set bits of each byte of x, in that byte */
+static inline uint64_t byte_counts(uint64_t x) {
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+}
+
+static inline pair pair_byte_counts(pair x) {
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+}
+
+/* Sum of the bytes of a word, through 16-bit lanes so it may exceed 255 */
+static inline long byte_sum(uint64_t x) {
+	x = (x & 0x00ff00ff00ff00ffULL) + ((x >> 8) & 0x00ff00ff00ff00ffULL);
+	return x * 0x0001000100010001ULL >> 48;
+}
+
+/* Bit count of a pair, weighted */
+#define PAIR_COUNT(x, weight)	((weight) * (byte_sum(pair_byte_counts(x)[0]) + byte_sum(pair_byte_counts(x)[1])))
+
+/* Carry-save add of a, b, c into high h and low l, on 128 lanes */
+#define CSA(h, l, a, b, c) \
+	do { \
+		pair _u = (a) ^ (b); \
+		(h) = ((a) & (b)) | (_u & (c)); \
+		(l) = _u ^ (c); \
+	} while(0)
+
+static inline pair pair_load(const uint64_t * p) {
+	pair v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/* Population and births so far, as carry-save counters (see row_counts) */
+struct counts {
+	pair p1, p2, p4, p8;	//population: ones, twos, fours, byte counts of eights
+	pair b1, b2, b4, b8;	//births
+	int blocks;		//eights added to p8, b8
+	long pop, born;
+};
+
+/* Move the byte counts of eights into pop and born, before their bytes overflow */
+static inline void counts_flush(struct counts * c) {
+	const pair zero = { 0, 0 };
+
+	c->pop += 8 * (byte_sum(c->p8[0]) + byte_sum(c->p8[1]));
+	c->born += 8 * (byte_sum(c->b8[0]) + byte_sum(c->b8[1]));
+	c->p8 = c->b8 = zero;
+	c->blocks = 0;
+}
+
+/*
+ * Add the population of out[1..W] and its births (cells not set in mid)
+ * to c, Harley-Seal style: see the comment at the top.
+ */
+static void row_counts(const uint64_t * out, const uint64_t * mid, int W, struct counts * c) {
+	pair p1 = c->p1, p2 = c->p2, p4 = c->p4, p8 = c->p8;
+	pair b1 = c->b1, b2 = c->b2, b4 = c->b4, b8 = c->b8;
+	pair h2a, h2b, h4a, h4b, h8;
+	int w;
+
+	for ( w = 1 ; w + 16 <= W + 1 ; w += 16 ) {
+#define O(k)	pair_load(out + w + 2*k)
+#define X(k)	(pair_load(out + w + 2*k) & ~pair_load(mid + w + 2*k))
+		CSA(h2a, p1, p1, O(0), O(1)); CSA(h2b, p1, p1, O(2), O(3)); CSA(h4a, p2, p2, h2a, h2b);
+		CSA(h2a, p1, p1, O(4), O(5)); CSA(h2b, p1, p1, O(6), O(7)); CSA(h4b, p2, p2, h2a, h2b);
+		CSA(h8, p4, p4, h4a, h4b);
+		p8 += pair_byte_counts(h8);
+		CSA(h2a, b1, b1, X(0), X(1)); CSA(h2b, b1, b1, X(2), X(3)); CSA(h4a, b2, b2, h2a, h2b);
+		CSA(h2a, b1, b1, X(4), X(5)); CSA(h2b, b1, b1, X(6), X(7)); CSA(h4b, b2, b2, h2a, h2b);
+		CSA(h8, b4, b4, h4a, h4b);
+		b8 += pair_byte_counts(h8);
+#undef O
+#undef X
+		if ( ++c->blocks == 31 ) {
+			c->p8 = p8;
+			c->b8 = b8;
+			counts_flush(c);
+			p8 = c->p8;
+			b8 = c->b8;
+		}
+	}
+	for ( ; w <= W ; w++ ) {
+		c->pop += byte_sum(byte_counts(out[w]));
+		c->born += byte_sum(byte_counts(out[w] & ~mid[w]));
+	}
+	c->p1 = p1; c->p2 = p2; c->p4 = p4; c->p8 = p8;
+	c->b1 = b1; c->b2 = b2; c->b4 = b4; c->b8 = b8;
+}
+
+/* One generation of all rows, previous -> current, counting into st if stats */
+static inline __attribute__((always_inline))
+void life_rows(const uint64_t * previous, uint64_t * current, const uint64_t * mask,
+	       int N, int W, int S, unsigned int birth, unsigned int survive,
+	       int stats, struct life_stats * st) {
+	struct counts c;
+	int i, w;
+
+	memset(&c, 0, sizeof(c));
+
+	for ( i = 1 ; i < N-1 ; i++ ) {
+		const uint64_t * up = previous + (size_t)(i-1)*S;
+		const uint64_t * mid = up + S;
+		const uint64_t * dn = mid + S;
+		uint64_t * out = current + (size_t)i*S;
+		for ( w = 1 ; w <= W ; w++ )
+			out[w] = life_word(up, mid, dn, w, birth, survive) & mask[w];
+		if ( stats )
+			row_counts(out, mid, W, &c);
+	}
+	if ( stats ) {
+		counts_flush(&c);
+		c.pop += PAIR_COUNT(c.p4, 4) + PAIR_COUNT(c.p2, 2) + PAIR_COUNT(c.p1, 1);
+		c.born += PAIR_COUNT(c.b4, 4) + PAIR_COUNT(c.b2, 2) + PAIR_COUNT(c.b1, 1);
+		st->deaths = st->population + c.born - c.pop;	//st holds the previous population
+		st->population = c.pop;
+		st->births = c.born;
+	}
+}
+
+/* packed_<name>, packed_<name>_stats for every known rule, and packed_generic* */
+#define PACKED_KERNELS(name, b, s) \
+static void packed_##name(const uint64_t * previous, uint64_t * current, const uint64_t * mask, \
+			  int N, int W, int S, unsigned int birth, unsigned int survive, \
+			  struct life_stats * st) { \
+	life_rows(previous, current, mask, N, W, S, b, s, 0, st); \
+} \
+static void packed_##name##_stats(const uint64_t * previous, uint64_t * current, const uint64_t * mask, \
+				  int N, int W, int S, unsigned int birth, unsigned int survive, \
+				  struct life_stats * st) { \
+	life_rows(previous, current, mask, N, W, S, b, s, 1, st); \
+}
+#define PACKED_KERNEL(name, bs, b, s)	PACKED_KERNELS(name, b, s)
+KNOWN_RULES(PACKED_KERNEL)
+PACKED_KERNELS(generic, birth, survive)
+
+static void * packed_init(int ** board, const struct life_params * p) {
+	struct packed_ctx * c = calloc(1, sizeof(*c));
+	int N = p->N, i, j;
+
+	c->N = N;
+	c->rule = p->rule;
+	c->kernel = p->stats ? packed_generic_stats : packed_generic;
+#define X(name, bs, birth, survive) \
+	if ( RULE_IS(&p->rule, birth, survive) ) \
+		c->kernel = p->stats ? packed_##name##_stats : packed_##name;
+	KNOWN_RULES(X)
+#undef X
+	c->W = (N + 63) / 64;
+	c->S = c->W + 2;
+	c->torus = p->torus;
+	c->current = (uint64_t *)calloc((size_t)(N+2) * c->S, sizeof(uint64_t)) + c->S;
+	c->previous = (uint64_t *)calloc((size_t)(N+2) * c->S, sizeof(uint64_t)) + c->S;
+	c->mask = calloc(c->S, sizeof(uint64_t));
+
+	for ( j = c->torus ? 0 : 1 ; j < (c->torus ? N : N-1) ; j++ )
+		c->mask[1 + j/64] |= (uint64_t)1 << (j%64);
+
+	for ( i = 0 ; i < N ; i++ )
+		for ( j = 0 ; j < N ; j++ )
+			if ( board[i][j] )
+				c->previous[(size_t)i*c->S + 1 + j/64] |= (uint64_t)1 << (j%64);
+	c->population = board_population(board, N);
+	return c;
+}
+
+/* Copy the opposite edges into the ghost bits and ghost rows of a */
+static void wrap(uint64_t * a, int N, int S) {
+	uint64_t * row;
+	int i;
+
+	for ( i = 0 ; i < N ; i++ ) {
+		row = a + (size_t)i*S;
+		row[0] = ((row[1 + (N-1)/64] >> ((N-1)%64)) & 1) << 63;
+		row[1 + N/64] = (row[1 + N/64] & ~((uint64_t)1 << (N%64))) | ((row[1] & 1) << (N%64));
+	}
+	memcpy(a - S, a + (size_t)(N-1)*S, S * sizeof(uint64_t));
+	memcpy(a + (size_t)N*S, a, S * sizeof(uint64_t));
+}
+
+static void packed_step(void * ctx, int steps) {
+	struct packed_ctx * c = ctx;
+	int N = c->N, W = c->W, S = c->S;
+	uint64_t * current = c->current, * previous = c->previous, * swap;
+	const uint64_t * mask = c->mask;
+	int t, M = c->torus ? N+2 : N, off = c->torus ? -S : 0;
+
+	if ( steps > c->series_len ) {
+		c->series = realloc(c->series, steps * sizeof(struct life_stats));
+		c->series_len = steps;
+	}
+	for ( t = 0 ; t < steps ; t++ ) {
+		//on a torus rows -1..N are handed to the kernel as 0..N+1
+		if ( c->torus )
+			wrap(previous, N, S);
+		c->series[t].population = t ? c->series[t-1].population : c->population;
+		c->kernel(previous + off, current + off, mask, M, W, S, c->rule.birth, c->rule.survive, &c->series[t]);
+
+		swap=current;
+		current=previous;
+		previous=swap;
+	}
+	c->current = current;
+	c->previous = previous;
+	if ( steps > 0 )
+		c->population = c->series[steps-1].population;
+}
+
+static void packed_get(void * ctx, int ** board) {
+	struct packed_ctx * c = ctx;
+	int i, j;
+
+	for ( i = 0 ; i < c->N ; i++ )
+		for ( j = 0 ; j < c->N ; j++ )
+			board[i][j] = (c->previous[(size_t)i*c->S + 1 + j/64] >> (j%64)) & 1;
+}
+
+static const struct life_stats * packed_stats(void * ctx) {
+	struct packed_ctx * c = ctx;
+	return c->series;
+}
+
+static void packed_finalize(void * ctx) {
+	struct packed_ctx * c = ctx;
+	free(c->series);
+	free(c->current - c->S);
+	free(c->previous - c->S);
+	free(c->mask);
+	free(c);
+}
+
+const struct life_engine packed_engine = {
+	"packed", packed_init, packed_step, packed_get, packed_finalize, NULL, 1, 1, packed_stats
+};
@@ -0,0 +1,433 @@
+/*
+ * SIMD engine: hand-written row kernels on the flat byte grid.
+ *
+ * Per output vector the kernel forms the column sums up+mid+dn at offsets
+ * j-1, j and j+1 (a 3-wide sliding window over the three rows), adds them
+ * and subtracts the centre, which gives all eight neighbour counts in one
+ * byte lane each. The rule is then one compare and one blend:
+ * (nbrs | self) == 3 selects 1, everything else 0.
+ *
+ * Other rules go through a 32-byte table, the next state of a dead and of
+ * a live cell for each count: one byte shuffle (vpshufb) per half of the
+ * table and a blend on self. SSE2 has no byte shuffle, so below AVX2 the
+ * table is looked up one cell at a time.
+ *
+ * A torus runs the same row kernels over the grid shifted by one row and
+ * column after its ghost border is filled, as in the flat engine.
+ *
+ * With -S the kernels count the population and births of each output
+ * vector while it is still in registers; deaths follow from the previous
+ * population.
+ *
+ * Kernels for AVX-512BW, AVX2 and SSE2 are compiled into the same binary
+ * with target attributes, and the widest one the CPU supports is picked at
+ * start-up with CPUID. Set LIFE_ISA=avx512|avx2|sse2|scalar to force one,
+ * or LIFE_ISA_OFF to a comma separated list of them to treat as missing,
+ * which exercises the fallback on a host that has them all (make check).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "life.h"
+
+/*
+ * A row kernel computes out[j] for 1 <= j < n-1 of a row of n cells. With
+ * pop set (-S) it also adds the row's population to *pop and its births to
+ * *born; both are NULL otherwise. The test is loop invariant, so the
+ * compiler unswitches it out of the plain loop.
+ */
+typedef void (*row_kernel)(const unsigned char * up, const unsigned char * mid,
+			   const unsigned char * dn, unsigned char * out, int n,
+			   const unsigned char * lut, long * pop, long * born);
+
+/* 3x3 sums of a vector of cells minus the centre: the neighbour counts */
+#define NBRS(T, load, add, sub, up, mid, dn, j, self) \
+	sub(add(add(add(add(load((const T *)(up+j-1)), load((const T *)(mid+j-1))), load((const T *)(dn+j-1))), \
+		    add(add(load((const T *)(up+j)), self), load((const T *)(dn+j)))), \
+		add(add(load((const T *)(up+j+1)), load((const T *)(mid+j+1))), load((const T *)(dn+j+1)))), self)
+
+static void row_scalar(const unsigned char * up, const unsigned char * mid,
+		       const unsigned char * dn, unsigned char * out, int n,
+		       const unsigned char * lut, long * pop, long * born) {
+	unsigned char nbrs;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j < n-1 ; j++ ) {
+		nbrs = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + dn[j-1] + dn[j] + dn[j+1];
+		out[j] = ( nbrs | mid[j] ) == 3;
+		p += out[j];
+		b += out[j] & ~mid[j];
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+}
+
+/* lut[16*self + nbrs] is the next state */
+static void rule_scalar(const unsigned char * up, const unsigned char * mid,
+			const unsigned char * dn, unsigned char * out, int n,
+			const unsigned char * lut, long * pop, long * born) {
+	unsigned char nbrs;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j < n-1 ; j++ ) {
+		nbrs = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + dn[j-1] + dn[j] + dn[j+1];
+		out[j] = lut[16*mid[j] + nbrs];
+		p += out[j];
+		b += out[j] & ~mid[j];
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+}
+
+/* SSE2 has no usable popcount: byte lanes, summed with psadbw every 255 vectors */
+__attribute__((target("sse2")))
+static void row_sse2(const unsigned char * up, const unsigned char * mid,
+		     const unsigned char * dn, unsigned char * out, int n,
+		     const unsigned char * lut, long * pop, long * born) {
+	const __m128i three = _mm_set1_epi8(3), one = _mm_set1_epi8(1), zero = _mm_setzero_si128();
+	__m128i vl, vc, vr, self, nbrs, o;
+	__m128i bp = zero, bb = zero, sp = zero, sb = zero;
+	int j, k = 0;
+
+	for ( j = 1 ; j + 16 <= n-1 ; j += 16 ) {
+		vl = _mm_add_epi8(_mm_add_epi8(_mm_loadu_si128((const __m128i *)(up+j-1)),
+					       _mm_loadu_si128((const __m128i *)(mid+j-1))),
+				  _mm_loadu_si128((const __m128i *)(dn+j-1)));
+		self = _mm_loadu_si128((const __m128i *)(mid+j));
+		vc = _mm_add_epi8(_mm_add_epi8(_mm_loadu_si128((const __m128i *)(up+j)), self),
+				  _mm_loadu_si128((const __m128i *)(dn+j)));
+		vr = _mm_add_epi8(_mm_add_epi8(_mm_loadu_si128((const __m128i *)(up+j+1)),
+					       _mm_loadu_si128((const __m128i *)(mid+j+1))),
+				  _mm_loadu_si128((const __m128i *)(dn+j+1)));
+		nbrs = _mm_sub_epi8(_mm_add_epi8(_mm_add_epi8(vl, vc), vr), self);
+		o = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(nbrs, self), three), one);
+		_mm_storeu_si128((__m128i *)(out+j), o);
+		if ( pop ) {
+			bp = _mm_add_epi8(bp, o);
+			bb = _mm_add_epi8(bb, _mm_andnot_si128(self, o));
+			if ( ++k == 255 ) {
+				sp = _mm_add_epi64(sp, _mm_sad_epu8(bp, zero));
+				sb = _mm_add_epi64(sb, _mm_sad_epu8(bb, zero));
+				bp = bb = zero;
+				k = 0;
+			}
+		}
+	}
+	if ( pop ) {
+		sp = _mm_add_epi64(sp, _mm_sad_epu8(bp, zero));
+		sb = _mm_add_epi64(sb, _mm_sad_epu8(bb, zero));
+		*pop += _mm_cvtsi128_si64(sp) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sp, sp));
+		*born += _mm_cvtsi128_si64(sb) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sb, sb));
+	}
+	row_scalar(up+j-1, mid+j-1, dn+j-1, out+j-1, n-j+1, lut, pop, born);
+}
+
+/*
+ * From AVX2 up the counts come from bit masks of the live cells: one
+ * movemask (AVX2) or the compare mask itself (AVX-512), then popcount.
+ * Every CPU with AVX2 has POPCNT.
+ */
+__attribute__((target("avx2,popcnt")))
+static void row_avx2(const unsigned char * up, const unsigned char * mid,
+		     const unsigned char * dn, unsigned char * out, int n,
+		     const unsigned char * lut, long * pop, long * born) {
+	const __m256i three = _mm256_set1_epi8(3), one = _mm256_set1_epi8(1);
+	__m256i vl, vc, vr, self, nbrs, alive;
+	unsigned int m;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j + 32 <= n-1 ; j += 32 ) {
+		vl = _mm256_add_epi8(_mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up+j-1)),
+						     _mm256_loadu_si256((const __m256i *)(mid+j-1))),
+				     _mm256_loadu_si256((const __m256i *)(dn+j-1)));
+		self = _mm256_loadu_si256((const __m256i *)(mid+j));
+		vc = _mm256_add_epi8(_mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up+j)), self),
+				     _mm256_loadu_si256((const __m256i *)(dn+j)));
+		vr = _mm256_add_epi8(_mm256_add_epi8(_mm256_loadu_si256((const __m256i *)(up+j+1)),
+						     _mm256_loadu_si256((const __m256i *)(mid+j+1))),
+				     _mm256_loadu_si256((const __m256i *)(dn+j+1)));
+		nbrs = _mm256_sub_epi8(_mm256_add_epi8(_mm256_add_epi8(vl, vc), vr), self);
+		alive = _mm256_cmpeq_epi8(_mm256_or_si256(nbrs, self), three);
+		_mm256_storeu_si256((__m256i *)(out+j), _mm256_and_si256(alive, one));
+		if ( pop ) {
+			m = _mm256_movemask_epi8(alive);
+			p += __builtin_popcount(m);
+			b += __builtin_popcount(m & ~_mm256_movemask_epi8(_mm256_slli_epi16(self, 7)));
+		}
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+	_mm256_zeroupper();		//the tail is legacy SSE code, avoid the transition penalty
+	row_sse2(up+j-1, mid+j-1, dn+j-1, out+j-1, n-j+1, lut, pop, born);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void row_avx512(const unsigned char * up, const unsigned char * mid,
+		       const unsigned char * dn, unsigned char * out, int n,
+		       const unsigned char * lut, long * pop, long * born) {
+	const __m512i three = _mm512_set1_epi8(3), one = _mm512_set1_epi8(1);
+	__m512i vl, vc, vr, self, nbrs;
+	__mmask64 alive;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j + 64 <= n-1 ; j += 64 ) {
+		vl = _mm512_add_epi8(_mm512_add_epi8(_mm512_loadu_si512(up+j-1), _mm512_loadu_si512(mid+j-1)),
+				     _mm512_loadu_si512(dn+j-1));
+		self = _mm512_loadu_si512(mid+j);
+		vc = _mm512_add_epi8(_mm512_add_epi8(_mm512_loadu_si512(up+j), self), _mm512_loadu_si512(dn+j));
+		vr = _mm512_add_epi8(_mm512_add_epi8(_mm512_loadu_si512(up+j+1), _mm512_loadu_si512(mid+j+1)),
+				     _mm512_loadu_si512(dn+j+1));
+		nbrs = _mm512_sub_epi8(_mm512_add_epi8(_mm512_add_epi8(vl, vc), vr), self);
+		alive = _mm512_cmpeq_epi8_mask(_mm512_or_si512(nbrs, self), three);
+		_mm512_storeu_si512(out+j, _mm512_maskz_mov_epi8(alive, one));
+		if ( pop ) {
+			p += __builtin_popcountll(alive);
+			b += __builtin_popcountll(alive & ~_mm512_test_epi8_mask(self, self));
+		}
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+	row_avx2(up+j-1, mid+j-1, dn+j-1, out+j-1, n-j+1, lut, pop, born);
+}
+
+__attribute__((target("avx2,popcnt")))
+static void rule_avx2(const unsigned char * up, const unsigned char * mid,
+		      const unsigned char * dn, unsigned char * out, int n,
+		      const unsigned char * lut, long * pop, long * born) {
+	const __m256i birth = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut));
+	const __m256i kept = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(lut+16)));
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i self, nbrs, live, o;
+	unsigned int m;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j + 32 <= n-1 ; j += 32 ) {
+		self = _mm256_loadu_si256((const __m256i *)(mid+j));
+		nbrs = NBRS(__m256i, _mm256_loadu_si256, _mm256_add_epi8, _mm256_sub_epi8, up, mid, dn, j, self);
+		live = _mm256_cmpgt_epi8(self, zero);
+		o = _mm256_blendv_epi8(_mm256_shuffle_epi8(birth, nbrs), _mm256_shuffle_epi8(kept, nbrs), live);
+		_mm256_storeu_si256((__m256i *)(out+j), o);
+		if ( pop ) {
+			m = _mm256_movemask_epi8(_mm256_slli_epi16(o, 7));
+			p += __builtin_popcount(m);
+			b += __builtin_popcount(m & ~_mm256_movemask_epi8(live));
+		}
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+	_mm256_zeroupper();
+	rule_scalar(up+j-1, mid+j-1, dn+j-1, out+j-1, n-j+1, lut, pop, born);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void rule_avx512(const unsigned char * up, const unsigned char * mid,
+			const unsigned char * dn, unsigned char * out, int n,
+			const unsigned char * lut, long * pop, long * born) {
+	const __m512i birth = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)lut));
+	const __m512i kept = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(lut+16)));
+	__m512i self, nbrs, o;
+	__mmask64 live;
+	long p = 0, b = 0;
+	int j;
+
+	for ( j = 1 ; j + 64 <= n-1 ; j += 64 ) {
+		self = _mm512_loadu_si512(mid+j);
+		nbrs = NBRS(void, _mm512_loadu_si512, _mm512_add_epi8, _mm512_sub_epi8, up, mid, dn, j, self);
+		live = _mm512_test_epi8_mask(self, self);
+		o = _mm512_mask_blend_epi8(live, _mm512_shuffle_epi8(birth, nbrs), _mm512_shuffle_epi8(kept, nbrs));
+		_mm512_storeu_si512(out+j, o);
+		if ( pop ) {
+			p += __builtin_popcountll(_mm512_test_epi8_mask(o, o));
+			b += __builtin_popcountll(_mm512_test_epi8_mask(o, o) & ~live);
+		}
+	}
+	if ( pop ) {
+		*pop += p;
+		*born += b;
+	}
+	rule_avx2(up+j-1, mid+j-1, dn+j-1, out+j-1, n-j+1, lut, pop, born);
+}
+
+static const struct {
+	const char * name;
+	const char * feature;		//for __builtin_cpu_supports, NULL: always
+	row_kernel kernel;		//B3/S23
+	row_kernel rule;		//any rule, through the lookup table
+} kernels[] = {
+	{ "avx512", "avx512bw", row_avx512, rule_avx512 },
+	{ "avx2", "avx2", row_avx2, rule_avx2 },
+	{ "sse2", "sse2", row_sse2, rule_scalar },
+	{ "scalar", NULL, row_scalar, rule_scalar },
+};
+
+#define NKERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static int cpu_has(const char * feature) {
+	__builtin_cpu_init();
+	if ( feature == NULL )
+		return 1;
+	if ( strcmp(feature, "avx512bw") == 0 )
+		return __builtin_cpu_supports("avx512bw");
+	if ( strcmp(feature, "avx2") == 0 )
+		return __builtin_cpu_supports("avx2");
+	if ( strcmp(feature, "sse2") == 0 )
+		return __builtin_cpu_supports("sse2");
+	return 0;
+}
+
+/* Kernel name is listed in LIFE_ISA_OFF; the scalar one is always there */
+static int isa_off(const char * name) {
+	const char * off = getenv("LIFE_ISA_OFF");
+	size_t n = strlen(name);
+
+	if ( strcmp(name, "scalar") == 0 )
+		return 0;
+	while ( off && *off ) {
+		if ( strncmp(off, name, n) == 0 && ( off[n] == ',' || off[n] == '\0' ) )
+			return 1;
+		off = strchr(off, ',');
+		if ( off )
+			off++;
+	}
+	return 0;
+}
+
+/* Widest supported kernel, or the one named by LIFE_ISA */
+static int select_kernel(void) {
+	char * isa = getenv("LIFE_ISA");
+	unsigned int k;
+
+	for ( k = 0 ; k < NKERNELS ; k++ ) {
+		if ( isa && strcmp(isa, kernels[k].name) )
+			continue;
+		if ( cpu_has(kernels[k].feature) && !isa_off(kernels[k].name) )
+			return k;
+		if ( isa ) {
+			fprintf(stderr, "LIFE_ISA=%s is not supported by this cpu\n", isa);
+			exit(1);
+		}
+	}
+	if ( isa ) {
+		fprintf(stderr, "LIFE_ISA=%s: unknown kernel\n", isa);
+		exit(1);
+	}
+	return NKERNELS - 1;
+}
+
+struct simd_ctx {
+	struct grid current, previous;
+	int kernel;
+	int conway;			//rule is B3/S23
+	int torus;
+	unsigned char lut[32];		//next state by 16*self + nbrs
+	int stats;
+	struct life_stats * series;	//per generation of the last step, with -S
+	int series_len;
+	long population;		//current population, with -S
+};
+
+static void * simd_init(int ** board, const struct life_params * p) {
+	struct simd_ctx * c = calloc(1, sizeof(*c));
+	int n;
+
+	c->kernel = select_kernel();
+	c->conway = RULE_IS(&p->rule, 0x008, 0x00c);
+	c->torus = p->torus;
+	c->stats = p->stats;
+	for ( n = 0 ; n <= 8 ; n++ ) {
+		c->lut[n] = p->rule.birth >> n & 1;
+		c->lut[16+n] = p->rule.survive >> n & 1;
+	}
+	grid_alloc(&c->current, p->N);
+	grid_alloc(&c->previous, p->N);
+	grid_load(&c->previous, board);
+	c->population = board_population(board, p->N);
+	return c;
+}
+
+static void simd_step(void * ctx, int steps) {
+	struct simd_ctx * c = ctx;
+	row_kernel kernel = c->conway ? kernels[c->kernel].kernel : kernels[c->kernel].rule;
+	ptrdiff_t S = c->current.stride, off = c->torus ? -S-1 : 0;
+	int N = c->torus ? c->current.N+2 : c->current.N;
+	struct grid swap;
+	long pop, born, last = c->population;
+	int t, i;
+
+	if ( c->stats && steps > c->series_len ) {
+		c->series = realloc(c->series, steps * sizeof(struct life_stats));
+		c->series_len = steps;
+	}
+	for ( t = 0 ; t < steps ; t++ ) {
+		unsigned char * cur = c->current.cells + off;
+		const unsigned char * prev = c->previous.cells + off;
+
+		if ( c->torus )
+			grid_wrap(&c->previous);
+
+		if ( c->stats ) {
+			pop = born = 0;
+			#pragma omp parallel for schedule(static) reduction(+:pop,born)
+			for ( i = 1 ; i < N-1 ; i++ )
+				kernel(prev + (i-1)*S, prev + i*S, prev + (i+1)*S, cur + i*S, N, c->lut, &pop, &born);
+			c->series[t].population = pop;
+			c->series[t].births = born;
+			c->series[t].deaths = last + born - pop;
+			last = pop;
+		}
+		else {
+			#pragma omp parallel for schedule(static)
+			for ( i = 1 ; i < N-1 ; i++ )
+				kernel(prev + (i-1)*S, prev + i*S, prev + (i+1)*S, cur + i*S, N, c->lut, NULL, NULL);
+		}
+
+		swap = c->current;
+		c->current = c->previous;
+		c->previous = swap;
+	}
+	c->population = last;
+}
+
+static void simd_get(void * ctx, int ** board) {
+	struct simd_ctx * c = ctx;
+	grid_store(&c->previous, board);
+}
+
+static void simd_report(void * ctx) {
+	struct simd_ctx * c = ctx;
+	printf("Kernel %s%s\n", kernels[c->kernel].name, c->conway ? "" : " (rule table)");
+}
+
+static const struct life_stats * simd_stats(void * ctx) {
+	struct simd_ctx * c = ctx;
+	return c->series;
+}
+
+static void simd_finalize(void * ctx) {
+	struct simd_ctx * c = ctx;
+	free(c->series);
+	grid_free(&c->current);
+	grid_free(&c->previous);
+	free(c);
+}
+
+const struct life_engine simd_engine = {
+	"simd", simd_init, simd_step, simd_get, simd_finalize, simd_report, 1, 1, simd_stats
+};
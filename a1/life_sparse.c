@@ -0,0 +1,161 @@
+/*
+ * Activity-tracking engine: only tiles that can change are recomputed.
+ *
+ * The interior is cut into B x B tiles. A tile can only change in
+ * generation t+1 if it or one of its 8 neighbour tiles changed in
+ * generation t, so after every step the tiles that changed are dilated by
+ * one tile into the active list of the next step, and everything else is
+ * skipped. Both buffers start out equal and a tile only drops out of the
+ * active list after a step in which it was recomputed without changing, so
+ * a skipped tile always holds the same cells in both buffers and skipping
+ * it is exact. A step with an empty active list costs nothing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+
+struct sparse_ctx {
+	int N;
+	int B;				//tile size
+	int nt;				//tiles per row/column
+	int verbose;
+	int ** current, ** previous;
+	int * active, nactive;		//tiles to compute in the next step
+	int * next;			//scratch for building the next active list
+	unsigned char * changed;	//per tile: changed in the last step
+	unsigned char * marked;		//per tile: already in next
+	int * history, nsteps, maxsteps;	//active tiles of every step, for report
+	long updates;			//total tile updates
+};
+
+static void * sparse_init(int ** board, const struct life_params * p) {
+	struct sparse_ctx * c = malloc(sizeof(*c));
+	int i, tiles;
+
+	c->N = p->N;
+	c->B = p->tile;
+	c->nt = (c->N-2 + c->B-1) / c->B;
+	c->verbose = p->verbose;
+	tiles = c->nt * c->nt;
+	c->current = allocate_array(c->N);
+	c->previous = allocate_array(c->N);
+	copy_array(c->current, board, c->N);
+	copy_array(c->previous, board, c->N);
+	c->active = malloc(tiles * sizeof(int));
+	c->next = malloc(tiles * sizeof(int));
+	c->changed = calloc(tiles, 1);
+	c->marked = calloc(tiles, 1);
+	c->maxsteps = p->T;
+	c->history = malloc((p->T > 0 ? p->T : 1) * sizeof(int));
+	c->nsteps = 0;
+	c->updates = 0;
+
+	//the first step has to look at everything
+	c->nactive = tiles;
+	for ( i = 0 ; i < tiles ; i++ )
+		c->active[i] = i;
+	return c;
+}
+
+/* Compute one tile, return whether any of its cells changed */
+static int tile_update(int ** previous, int ** current, int N, int B, int r0, int c0) {
+	int r1 = r0+B < N-1 ? r0+B : N-1;
+	int c1 = c0+B < N-1 ? c0+B : N-1;
+	int i, j, nbrs, diff = 0;
+
+	for ( i = r0 ; i < r1 ; i++ )
+		for ( j = c0 ; j < c1 ; j++ ) {
+			nbrs = previous[i+1][j+1] + previous[i+1][j] + previous[i+1][j-1] \
+			       + previous[i][j-1] + previous[i][j+1] \
+			       + previous[i-1][j-1] + previous[i-1][j] + previous[i-1][j+1];
+			current[i][j] = ( nbrs | previous[i][j] ) == 3;
+			diff |= current[i][j] ^ previous[i][j];
+		}
+	return diff;
+}
+
+static void sparse_step(void * ctx, int steps) {
+	struct sparse_ctx * c = ctx;
+	int N = c->N, B = c->B, nt = c->nt;
+	int ** swap, * tmp;
+	int t, k, n, ti, tj, di, dj, nb;
+
+	for ( t = 0 ; t < steps ; t++ ) {
+		if ( c->nsteps < c->maxsteps )
+			c->history[c->nsteps++] = c->nactive;
+		c->updates += c->nactive;
+		if ( c->nactive == 0 )
+			continue;
+
+		#pragma omp parallel for schedule(dynamic,4) if(c->nactive > 1)
+		for ( k = 0 ; k < c->nactive ; k++ ) {
+			int tile = c->active[k];
+			c->changed[tile] = tile_update(c->previous, c->current, N, B,
+						       1 + (tile/nt)*B, 1 + (tile%nt)*B);
+		}
+
+		//next active list: changed tiles and their neighbours
+		n = 0;
+		for ( k = 0 ; k < c->nactive ; k++ ) {
+			int tile = c->active[k];
+			if ( !c->changed[tile] )
+				continue;
+			c->changed[tile] = 0;
+			ti = tile / nt;
+			tj = tile % nt;
+			for ( di = -1 ; di <= 1 ; di++ )
+				for ( dj = -1 ; dj <= 1 ; dj++ ) {
+					if ( ti+di < 0 || ti+di >= nt || tj+dj < 0 || tj+dj >= nt )
+						continue;
+					nb = (ti+di)*nt + tj+dj;
+					if ( !c->marked[nb] ) {
+						c->marked[nb] = 1;
+						c->next[n++] = nb;
+					}
+				}
+		}
+		for ( k = 0 ; k < n ; k++ )
+			c->marked[c->next[k]] = 0;
+		tmp = c->active;
+		c->active = c->next;
+		c->next = tmp;
+		c->nactive = n;
+
+		swap=c->current;
+		c->current=c->previous;
+		c->previous=swap;
+	}
+}
+
+static void sparse_get(void * ctx, int ** board) {
+	struct sparse_ctx * c = ctx;
+	copy_array(board, c->previous, c->N);
+}
+
+static void sparse_report(void * ctx) {
+	struct sparse_ctx * c = ctx;
+	int t;
+
+	if ( c->verbose )
+		for ( t = 0 ; t < c->nsteps ; t++ )
+			printf("Step %d ActiveTiles %d\n", t, c->history[t]);
+	printf("Tiles %d TileUpdates %ld AvgActive %.2f\n", c->nt*c->nt, c->updates,
+	       c->nsteps ? (double)c->updates/c->nsteps : 0.0);
+}
+
+static void sparse_finalize(void * ctx) {
+	struct sparse_ctx * c = ctx;
+	free_array(c->current, c->N);
+	free_array(c->previous, c->N);
+	free(c->active);
+	free(c->next);
+	free(c->changed);
+	free(c->marked);
+	free(c->history);
+	free(c);
+}
+
+const struct life_engine sparse_engine = {
+	"sparse", sparse_init, sparse_step, sparse_get, sparse_finalize, sparse_report
+};
@@ -0,0 +1,132 @@
+/*
+ * Temporally blocked engine (overlapped halos).
+ *
+ * Instead of streaming the whole board through memory once per generation,
+ * the board is cut into B x B tiles and each tile is advanced D generations
+ * at a time: the tile plus a halo of D cells on every side is copied into a
+ * small private byte buffer, stepped D times in cache while the valid region
+ * shrinks by one cell per generation, and only the B x B centre is written
+ * back. DRAM sees one read and one write of the board per D generations; the
+ * price is recomputing the halos, (B+2D)^2/B^2 - 1 extra work.
+ *
+ * Tiles are independent within a block of D generations, so they are
+ * distributed over the OpenMP threads.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "life.h"
+
+struct tiled_ctx {
+	int N;
+	int B;				//tile size
+	int D;				//generations per tile visit
+	int ** current, ** previous;
+};
+
+static void * tiled_init(int ** board, const struct life_params * p) {
+	struct tiled_ctx * c = malloc(sizeof(*c));
+
+	c->N = p->N;
+	c->B = p->tile;
+	c->D = p->depth;
+	c->current = allocate_array(c->N);
+	c->previous = allocate_array(c->N);
+	copy_array(c->previous, board, c->N);
+	return c;
+}
+
+/*
+ * Advance the tile with top-left interior cell (r0, c0) by d generations,
+ * reading generation t from src and writing generation t+d into dst.
+ * buf and tmp hold (B+2D)^2 cells each.
+ */
+static void tile_advance(int ** src, int ** dst, int N, int B, int r0, int c0, int d,
+			 unsigned char * buf, unsigned char * tmp) {
+	int r1 = r0+B < N-1 ? r0+B : N-1;	//tile is [r0,r1) x [c0,c1)
+	int c1 = c0+B < N-1 ? c0+B : N-1;
+	int lr = r0-d > 0 ? r0-d : 0;		//loaded region [lr,hr) x [lc,hc)
+	int hr = r1+d < N ? r1+d : N;
+	int lc = c0-d > 0 ? c0-d : 0;
+	int hc = c1+d < N ? c1+d : N;
+	int W = hc-lc;
+	unsigned char * swap;
+	int s, i, j, nbrs;
+
+	for ( i = lr ; i < hr ; i++ )
+		for ( j = lc ; j < hc ; j++ )
+			buf[(i-lr)*W + j-lc] = src[i][j];
+	//cells outside the shrinking valid region are never read again, but
+	//the dead frame is never written either, so keep it zero in tmp too
+	memcpy(tmp, buf, (size_t)(hr-lr)*W);
+
+	for ( s = 1 ; s <= d ; s++ ) {
+		int ilo = r0-d+s > 1 ? r0-d+s : 1, ihi = r1+d-s < N-1 ? r1+d-s : N-1;
+		int jlo = c0-d+s > 1 ? c0-d+s : 1, jhi = c1+d-s < N-1 ? c1+d-s : N-1;
+
+		for ( i = ilo ; i < ihi ; i++ ) {
+			const unsigned char * up = buf + (i-1-lr)*W;
+			const unsigned char * mid = up + W;
+			const unsigned char * dn = mid + W;
+			unsigned char * out = tmp + (i-lr)*W;
+			for ( j = jlo-lc ; j < jhi-lc ; j++ ) {
+				nbrs = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + dn[j-1] + dn[j] + dn[j+1];
+				out[j] = ( nbrs | mid[j] ) == 3;	//nbrs == 3 || self+nbrs == 3
+			}
+		}
+		swap = buf;
+		buf = tmp;
+		tmp = swap;
+	}
+
+	for ( i = r0 ; i < r1 ; i++ )
+		for ( j = c0 ; j < c1 ; j++ )
+			dst[i][j] = buf[(i-lr)*W + j-lc];
+}
+
+static void tiled_step(void * ctx, int steps) {
+	struct tiled_ctx * c = ctx;
+	int N = c->N, B = c->B, D = c->D;
+	int ntiles = (N-2 + B-1) / B;
+	int ** swap;
+	int t, d;
+
+	for ( t = 0 ; t < steps ; t += d ) {
+		d = steps-t < D ? steps-t : D;
+
+		#pragma omp parallel
+		{
+			size_t cells = (size_t)(B+2*d)*(B+2*d);
+			unsigned char * buf = malloc(cells);
+			unsigned char * tmp = malloc(cells);
+			int tile;
+
+			#pragma omp for schedule(static)
+			for ( tile = 0 ; tile < ntiles*ntiles ; tile++ )
+				tile_advance(c->previous, c->current, N, B,
+					     1 + (tile/ntiles)*B, 1 + (tile%ntiles)*B, d, buf, tmp);
+			free(buf);
+			free(tmp);
+		}
+
+		swap=c->current;
+		c->current=c->previous;
+		c->previous=swap;
+	}
+}
+
+static void tiled_get(void * ctx, int ** board) {
+	struct tiled_ctx * c = ctx;
+	copy_array(board, c->previous, c->N);
+}
+
+static void tiled_finalize(void * ctx) {
+	struct tiled_ctx * c = ctx;
+	free_array(c->current, c->N);
+	free_array(c->previous, c->N);
+	free(c);
+}
+
+const struct life_engine tiled_engine = {
+	"tiled", tiled_init, tiled_step, tiled_get, tiled_finalize
+};
@@ -0,0 +1,90 @@
+/*
+ * Pattern files in the RLE format used by Golly and the LifeWiki:
+ *
+ *   #C comment lines
+ *   x = 3, y = 3, rule = B3/S23
+ *   bo$2bo$3o!
+ *
+ * b is a dead cell, o (or any other letter) a live one, $ ends a row, and
+ * each may be preceded by a repeat count. The pattern is placed in the
+ * middle of the board, which must have room for it inside the dead frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "life.h"
+
+/*
+ * Load the RLE pattern at path into board (N x N, cleared first). If rule
+ * is not NULL and the file names one, it is parsed into *rule. Returns 0 on
+ * success.
+ */
+int pattern_load(const char * path, int ** board, int N, struct life_rule * rule) {
+	FILE * f = fopen(path, "r");
+	char line[1024], rule_str[64];
+	int w = -1, h = -1, i0, j0, i, j, n, c;
+
+	if ( !f ) {
+		perror(path);
+		return -1;
+	}
+
+	//header: skip comments up to the "x = .., y = .." line
+	while ( fgets(line, sizeof(line), f) ) {
+		if ( line[0] == '#' || line[0] == '\n' || line[0] == '\r' )
+			continue;
+		if ( sscanf(line, " x = %d , y = %d", &w, &h) != 2 ) {
+			fprintf(stderr, "%s: missing 'x = .., y = ..' header\n", path);
+			fclose(f);
+			return -1;
+		}
+		if ( rule && sscanf(line, " x = %*d , y = %*d , rule = %63s", rule_str) == 1
+		     && rule_parse(rule_str, rule) ) {
+			fprintf(stderr, "%s: bad rule '%s'\n", path, rule_str);
+			fclose(f);
+			return -1;
+		}
+		break;
+	}
+	if ( w < 0 || h < 0 ) {
+		fprintf(stderr, "%s: empty pattern file\n", path);
+		fclose(f);
+		return -1;
+	}
+	if ( w > N-2 || h > N-2 ) {
+		fprintf(stderr, "%s: %d x %d pattern does not fit in a board of size %d\n", path, w, h, N);
+		fclose(f);
+		return -1;
+	}
+
+	for ( i = 0 ; i < N ; i++ )
+		memset(board[i], 0, N * sizeof(int));
+	i0 = 1 + (N-2 - h) / 2;
+	j0 = 1 + (N-2 - w) / 2;
+
+	i = j = n = 0;
+	while ( (c = fgetc(f)) != EOF && c != '!' ) {
+		if ( isdigit(c) ) {
+			n = 10*n + c - '0';
+			continue;
+		}
+		if ( isspace(c) )
+			continue;
+		if ( n == 0 )
+			n = 1;
+		if ( c == '$' ) {
+			i += n;
+			j = 0;
+		}
+		else {
+			for ( ; n > 0 ; n--, j++ )
+				if ( c != 'b' && c != '.' && i < h && j < w )
+					board[i0+i][j0+j] = 1;
+		}
+		n = 0;
+	}
+	fclose(f);
+	return 0;
+}
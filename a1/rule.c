@@ -0,0 +1,65 @@
+/*
+ * Life-like rules in B/S notation ("B3/S23" is Conway's game).
+ *
+ * A rule is two 9-bit masks: bit n of birth is set if a dead cell with n
+ * live neighbours is born, bit n of survive if a live one stays alive.
+ * KNOWN_RULES (life.h) lists the rules some engines specialize their
+ * kernels on; see there for how the engines handle other rules.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "life.h"
+
+static const struct {
+	const char * name;
+	const char * bs;
+} aliases[] = {
+#define X(name, bs, birth, survive) { #name, bs },
+	KNOWN_RULES(X)
+#undef X
+};
+
+/* Parse "B36/S23" (or a known rule's name) into r, return 0 on success */
+int rule_parse(const char * s, struct life_rule * r) {
+	unsigned int * mask = NULL;
+	unsigned int i;
+
+	for ( i = 0 ; i < sizeof(aliases)/sizeof(aliases[0]) ; i++ )
+		if ( strcasecmp(s, aliases[i].name) == 0 )
+			s = aliases[i].bs;
+
+	r->birth = r->survive = 0;
+	for ( i = 0 ; s[i] ; i++ ) {
+		if ( toupper(s[i]) == 'B' )
+			mask = &r->birth;
+		else if ( toupper(s[i]) == 'S' )
+			mask = &r->survive;
+		else if ( s[i] >= '0' && s[i] <= '8' && mask )
+			*mask |= 1u << (s[i] - '0');
+		else if ( s[i] != '/' )
+			return -1;
+	}
+	if ( !mask )
+		return -1;
+	rule_name(r);
+	return 0;
+}
+
+/* Fill in r->name in canonical B/S form */
+void rule_name(struct life_rule * r) {
+	char * p = r->name;
+	int n;
+
+	*p++ = 'B';
+	for ( n = 0 ; n <= 8 ; n++ )
+		if ( r->birth >> n & 1 )
+			*p++ = '0' + n;
+	*p++ = '/';
+	*p++ = 'S';
+	for ( n = 0 ; n <= 8 ; n++ )
+		if ( r->survive >> n & 1 )
+			*p++ = '0' + n;
+	*p = '\0';
+}
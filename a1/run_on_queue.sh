@@ -0,0 +1,40 @@
+#!/bin/bash
+
+## Give the Job a descriptive name
+#PBS -N run_life
+
+## Output and error files
+#PBS -o run_life.out
+#PBS -e run_life.err
+
+## How many machines should we get? 
+#PBS -l nodes=1:ppn=8
+
+##How long should the job run for?
+#PBS -l walltime=00:10:00
+
+## Start 
+## Run make in the src folder (modify properly)
+
+module load openmp
+cd <FIX_PATH>
+for threads in 1 2 4 8
+do
+	export OMP_NUM_THREADS=$threads
+	./life -e omp -p 4096 100
+done
+
+## int ** rows vs one contiguous block of byte cells
+export OMP_NUM_THREADS=1
+for size in 64 256 1024 4096 8192
+do
+	./life -e dense $size 100
+	./life -e flat $size 100
+done
+
+## Throughput sweep: L1/L2/LLC/DRAM sizes x threads, CSV for plotting
+./life_bench -j 1,2,4,8 -o bench.csv
+
+## MPI version (make life_mpi), checked against the serial engine
+module load openmpi
+mpirun -np 4 ./life_mpi -c 4096 100 2 2
@@ -0,0 +1,55 @@
+/*
+ * Convert a snapshot stream written by ./life -o into one PGM image per
+ * frame (out<generation>.pgm), e.g. to make a gif with ImageMagick:
+ *
+ *   ./snap2pgm run.snap
+ *   convert -delay 20 `ls -1 out*.pgm | sort -V` output.gif
+ *
+ * WARNING: Do not convert streams of large boards or many frames!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+
+void print_to_pgm(int ** array, int N, int t) {
+	int i,j;
+	char * s = malloc(30*sizeof(char));
+	sprintf(s,"out%d.pgm",t);
+	FILE * f = fopen(s,"wb");
+	fprintf(f, "P5\n%d %d 1\n", N,N);
+	for ( i = 0; i < N ; i++ )
+		for ( j = 0; j < N ; j++)
+			if ( array[i][j]==1 )
+				fputc(1,f);
+			else
+				fputc(0,f);
+	fclose(f);
+	free(s);
+}
+
+int main(int argc, char * argv[]) {
+	FILE * f;
+	int ** board;
+	int N, every, t, frames = 0;
+
+	if ( argc != 2 ) {
+		fprintf(stderr, "Usage: %s SnapshotFile\n", argv[0]);
+		exit(-1);
+	}
+	f = fopen(argv[1], "rb");
+	if ( !f || snapshot_read_header(f, &N, &every) ) {
+		fprintf(stderr, "%s: not a snapshot stream\n", argv[1]);
+		exit(-1);
+	}
+
+	board = allocate_array(N);
+	while ( snapshot_read_frame(f, N, board, &t) == 0 ) {
+		print_to_pgm(board, N, t);
+		frames++;
+	}
+	fclose(f);
+	free_array(board, N);
+	printf("%d frames of size %d (every %d generations)\n", frames, N, every);
+	return 0;
+}
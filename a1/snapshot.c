@@ -0,0 +1,303 @@
+/*
+ * Streaming snapshot output.
+ *
+ * All sampled generations of a run go into one binary file:
+ *
+ *   header: "LIFESNAP" u32 version, u32 N, u32 every
+ *   frame:  u32 generation, u32 encoding, u64 payload bytes, payload
+ *
+ * Integers are little endian. A frame is either SNAP_PACKED (N rows of
+ * (N+7)/8 bytes, cell j in bit j%8 of byte j/8) or SNAP_RLE (row-major
+ * runs of alternating dead/alive cells, starting with dead, as LEB128
+ * varints), whichever is smaller.
+ *
+ * The compute thread only packs the board into a free slot of a small ring
+ * and returns; encoding and writing happen on a background thread. The
+ * compute thread waits only if the writer is a whole ring behind.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "life.h"
+
+#define SNAP_MAGIC	"LIFESNAP"
+#define SNAP_VERSION	1
+#define SNAP_SLOTS	4
+
+#define SNAP_PACKED	0
+#define SNAP_RLE	1
+
+struct snapshot {
+	FILE * f;
+	int N;
+	size_t row_bytes, frame_bytes;
+	unsigned char * slot[SNAP_SLOTS];	//packed boards waiting to be written
+	int gen[SNAP_SLOTS];
+	unsigned char * rle;			//writer's encode buffer
+	int head, tail, queued;			//ring: producer writes head, writer reads tail
+	int done;
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty, not_full;
+	pthread_t writer;
+	long bytes;				//bytes written
+};
+
+static void put_u32(FILE * f, uint32_t v) {
+	unsigned char b[4] = { v, v >> 8, v >> 16, v >> 24 };
+	fwrite(b, 1, 4, f);
+}
+
+static void put_u64(FILE * f, uint64_t v) {
+	put_u32(f, (uint32_t)v);
+	put_u32(f, (uint32_t)(v >> 32));
+}
+
+static int get_u32(FILE * f, uint32_t * v) {
+	unsigned char b[4];
+	if ( fread(b, 1, 4, f) != 4 )
+		return -1;
+	*v = b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+	return 0;
+}
+
+static int get_u64(FILE * f, uint64_t * v) {
+	uint32_t lo, hi;
+	if ( get_u32(f, &lo) || get_u32(f, &hi) )
+		return -1;
+	*v = lo | (uint64_t)hi << 32;
+	return 0;
+}
+
+/* RLE-encode a packed board into out, return its size or 0 if it would not beat packed */
+static size_t rle_encode(const unsigned char * packed, int N, size_t row_bytes, unsigned char * out, size_t limit) {
+	size_t n = 0;
+	uint64_t run = 0;
+	int cur = 0, i, j, bit;
+
+	for ( i = 0 ; i < N ; i++ )
+		for ( j = 0 ; j < N ; j++ ) {
+			bit = (packed[i*row_bytes + j/8] >> (j%8)) & 1;
+			if ( bit == cur ) {
+				run++;
+				continue;
+			}
+			do {
+				if ( n >= limit )
+					return 0;
+				out[n++] = (run & 0x7f) | (run > 0x7f ? 0x80 : 0);
+				run >>= 7;
+			} while ( run );
+			cur = bit;
+			run = 1;
+		}
+	do {
+		if ( n >= limit )
+			return 0;
+		out[n++] = (run & 0x7f) | (run > 0x7f ? 0x80 : 0);
+		run >>= 7;
+	} while ( run );
+	return n;
+}
+
+static void * writer(void * arg) {
+	struct snapshot * s = arg;
+	unsigned char * frame;
+	size_t len;
+	int gen;
+
+	for ( ;; ) {
+		pthread_mutex_lock(&s->lock);
+		while ( !s->queued && !s->done )
+			pthread_cond_wait(&s->not_empty, &s->lock);
+		if ( !s->queued ) {
+			pthread_mutex_unlock(&s->lock);
+			break;
+		}
+		frame = s->slot[s->tail];
+		gen = s->gen[s->tail];
+		pthread_mutex_unlock(&s->lock);
+
+		len = rle_encode(frame, s->N, s->row_bytes, s->rle, s->frame_bytes);
+		put_u32(s->f, gen);
+		if ( len ) {
+			put_u32(s->f, SNAP_RLE);
+			put_u64(s->f, len);
+			fwrite(s->rle, 1, len, s->f);
+		}
+		else {
+			len = s->frame_bytes;
+			put_u32(s->f, SNAP_PACKED);
+			put_u64(s->f, len);
+			fwrite(frame, 1, len, s->f);
+		}
+		s->bytes += 16 + len;
+
+		pthread_mutex_lock(&s->lock);
+		s->tail = (s->tail + 1) % SNAP_SLOTS;
+		s->queued--;
+		pthread_cond_signal(&s->not_full);
+		pthread_mutex_unlock(&s->lock);
+	}
+	return NULL;
+}
+
+struct snapshot * snapshot_open(const char * path, int N, int every) {
+	struct snapshot * s = calloc(1, sizeof(*s));
+	int i;
+
+	s->f = fopen(path, "wb");
+	if ( !s->f ) {
+		perror(path);
+		exit(1);
+	}
+	s->N = N;
+	s->row_bytes = (N + 7) / 8;
+	s->frame_bytes = s->row_bytes * N;
+	for ( i = 0 ; i < SNAP_SLOTS ; i++ )
+		s->slot[i] = malloc(s->frame_bytes);
+	s->rle = malloc(s->frame_bytes);
+
+	fwrite(SNAP_MAGIC, 1, 8, s->f);
+	put_u32(s->f, SNAP_VERSION);
+	put_u32(s->f, N);
+	put_u32(s->f, every);
+	s->bytes = 20;
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->not_empty, NULL);
+	pthread_cond_init(&s->not_full, NULL);
+	pthread_create(&s->writer, NULL, writer, s);
+	return s;
+}
+
+void snapshot_put(struct snapshot * s, int ** board, int t) {
+	unsigned char * frame;
+	int i, j;
+
+	pthread_mutex_lock(&s->lock);
+	while ( s->queued == SNAP_SLOTS )
+		pthread_cond_wait(&s->not_full, &s->lock);
+	frame = s->slot[s->head];
+	pthread_mutex_unlock(&s->lock);
+
+	memset(frame, 0, s->frame_bytes);
+	for ( i = 0 ; i < s->N ; i++ )
+		for ( j = 0 ; j < s->N ; j++ )
+			frame[i*s->row_bytes + j/8] |= (board[i][j] != 0) << (j%8);
+
+	pthread_mutex_lock(&s->lock);
+	s->gen[s->head] = t;
+	s->head = (s->head + 1) % SNAP_SLOTS;
+	s->queued++;
+	pthread_cond_signal(&s->not_empty);
+	pthread_mutex_unlock(&s->lock);
+}
+
+/* Flush outstanding frames, return the number of bytes written */
+long snapshot_close(struct snapshot * s) {
+	long bytes;
+	int i;
+
+	pthread_mutex_lock(&s->lock);
+	s->done = 1;
+	pthread_cond_signal(&s->not_empty);
+	pthread_mutex_unlock(&s->lock);
+	pthread_join(s->writer, NULL);
+
+	fclose(s->f);
+	for ( i = 0 ; i < SNAP_SLOTS ; i++ )
+		free(s->slot[i]);
+	free(s->rle);
+	pthread_mutex_destroy(&s->lock);
+	pthread_cond_destroy(&s->not_empty);
+	pthread_cond_destroy(&s->not_full);
+	bytes = s->bytes;
+	free(s);
+	return bytes;
+}
+
+/* Read the stream header, return 0 on success */
+int snapshot_read_header(FILE * f, int * N, int * every) {
+	char magic[8];
+	uint32_t version, n, k;
+
+	if ( fread(magic, 1, 8, f) != 8 || memcmp(magic, SNAP_MAGIC, 8) )
+		return -1;
+	if ( get_u32(f, &version) || version != SNAP_VERSION )
+		return -1;
+	if ( get_u32(f, &n) || get_u32(f, &k) )
+		return -1;
+	*N = n;
+	*every = k;
+	return 0;
+}
+
+/*
+ * Next LEB128 varint of buf[*n..len-1] into *run, advancing *n; -1 if it
+ * is cut off by the end of the buffer or does not fit 64 bits
+ */
+static int rle_run(const unsigned char * buf, size_t len, size_t * n, uint64_t * run) {
+	int shift = 0;
+
+	*run = 0;
+	do {
+		if ( *n == len || shift > 63 )
+			return -1;
+		*run |= (uint64_t)(buf[*n] & 0x7f) << shift;
+		shift += 7;
+	} while ( buf[(*n)++] & 0x80 );
+	return 0;
+}
+
+/*
+ * Read the next frame into board (N x N), return 0 on success, -1 at end
+ * of stream or on a bad frame. A frame is bad if its encoding is unknown,
+ * it is longer than a packed board (the writer never does that), a packed
+ * one is not exactly N rows, or the runs of an RLE one do not add up to
+ * exactly N*N cells; the board is left alone then.
+ */
+int snapshot_read_frame(FILE * f, int N, int ** board, int * t) {
+	uint32_t gen, enc;
+	uint64_t len, run, sum;
+	unsigned char * buf;
+	size_t row_bytes = (N + 7) / 8, n, pos = 0, total = (size_t)N * N;
+	int i, j, cur = 0;
+
+	if ( get_u32(f, &gen) || get_u32(f, &enc) || get_u64(f, &len) )
+		return -1;
+	if ( (enc != SNAP_PACKED && enc != SNAP_RLE) || len > row_bytes * N )
+		return -1;
+	buf = malloc(len ? len : 1);
+	if ( fread(buf, 1, len, f) != len || (enc == SNAP_PACKED && len != row_bytes * N) ) {
+		free(buf);
+		return -1;
+	}
+
+	if ( enc == SNAP_RLE ) {
+		for ( n = 0, sum = 0 ; n < len ; sum += run )
+			if ( rle_run(buf, len, &n, &run) || run > total - sum ) {
+				free(buf);
+				return -1;
+			}
+		if ( sum != total ) {
+			free(buf);
+			return -1;
+		}
+	}
+
+	if ( enc == SNAP_PACKED )
+		for ( i = 0 ; i < N ; i++ )
+			for ( j = 0 ; j < N ; j++ )
+				board[i][j] = (buf[i*row_bytes + j/8] >> (j%8)) & 1;
+	else
+		for ( n = 0 ; n < len ; cur ^= 1 )
+			for ( rle_run(buf, len, &n, &run) ; run ; run--, pos++ )
+				board[pos/N][pos%N] = cur;
+
+	free(buf);
+	*t = gen;
+	return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+## make check: kernel selection of the simd engine. LIFE_ISA_OFF hides
+## kernels as if the cpu lacked them, so every case runs on any x86 host.
+
+fail=0
+
+## expect <status> <pattern> <env...>: run a checked simd board with env
+expect()
+{
+	local status=$1 pattern=$2 out code
+	shift 2
+	out=$(env -u LIFE_ISA -u LIFE_ISA_OFF "$@" ./life -e simd -c 64 20 2>&1)
+	code=$?
+	if [ $code -ne $status ] || ! grep -q -- "$pattern" <<< "$out"; then
+		echo "FAIL: ${*:-defaults} (exit $code, expected $status and '$pattern')"
+		echo "$out" | sed 's/^/	/'
+		fail=1
+	else
+		echo "ok: ${*:-defaults}"
+	fi
+}
+
+## LIFE_ISA unset: fall back past missing kernels, down to scalar
+expect 0 "Check: OK"
+expect 0 "Kernel \(avx2\|sse2\|scalar\)$" LIFE_ISA_OFF=avx512
+expect 0 "Kernel \(sse2\|scalar\)$" LIFE_ISA_OFF=avx512,avx2
+expect 0 "Kernel scalar$" LIFE_ISA_OFF=avx512,avx2,sse2
+expect 0 "Check: OK" LIFE_ISA_OFF=avx512,avx2,sse2
+
+## LIFE_ISA set: a missing or unknown kernel is an error, never a fallback
+expect 1 "LIFE_ISA=avx512 is not supported by this cpu" LIFE_ISA=avx512 LIFE_ISA_OFF=avx512
+expect 1 "LIFE_ISA=avx2 is not supported by this cpu" LIFE_ISA=avx2 LIFE_ISA_OFF=avx512,avx2
+expect 1 "LIFE_ISA=bogus: unknown kernel" LIFE_ISA=bogus
+expect 0 "Kernel scalar$" LIFE_ISA=scalar LIFE_ISA_OFF=avx512,avx2,sse2
+
+exit $fail
@@ -0,0 +1,111 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+#include "life.h"
+
+int ** allocate_array(int N) {
+	int ** array;
+	int i,j;
+	array = malloc(N * sizeof(int*));
+	for ( i = 0; i < N ; i++ )
+		array[i] = malloc( N * sizeof(int));
+	for ( i = 0; i < N ; i++ )
+		for ( j = 0; j < N ; j++ )
+			array[i][j] = 0;
+	return array;
+}
+
+void free_array(int ** array, int N) {
+	int i;
+	for ( i = 0 ; i < N ; i++ )
+		free(array[i]);
+	free(array);
+}
+
+void copy_array(int ** dst, int ** src, int N) {
+	int i,j;
+	for ( i = 0 ; i < N ; i++ )
+		for ( j = 0 ; j < N ; j++ )
+			dst[i][j] = src[i][j];
+}
+
+/* Returns the number of cells in which a and b differ */
+int compare_array(int ** a, int ** b, int N) {
+	int i,j,diff=0;
+	for ( i = 0 ; i < N ; i++ )
+		for ( j = 0 ; j < N ; j++ )
+			if ( a[i][j] != b[i][j] )
+				diff++;
+	return diff;
+}
+
+/* Number of live cells */
+long board_population(int ** board, int N) {
+	long pop = 0;
+	int i, j;
+
+	for ( i = 0 ; i < N ; i++ )
+		for ( j = 0 ; j < N ; j++ )
+			pop += board[i][j] != 0;
+	return pop;
+}
+
+/*
+ * Counter-based random fill: cell (i,j) is alive with probability 1/10,
+ * decided by a SplitMix64 hash of (seed, i, j) alone. Rows can be filled
+ * in any order by any number of threads (or processes) and the board is
+ * always the same; a board of size N is also the top-left corner of any
+ * larger one with the same seed.
+ */
+int random_cell(unsigned int seed, int i, int j) {
+	uint64_t z = ((uint64_t)(uint32_t)i << 32 | (uint32_t)j) + (uint64_t)seed * 0xD1B54A32D192ED03ULL;
+
+	z += 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z ^= z >> 31;
+	return (z >> 32) < 0x1999999AULL;	//2^32 / 10
+}
+
+/* Random fill of the cells inside the dead frame */
+void init_random(int ** array, int N, unsigned int seed) {
+	int i, j;
+
+	#pragma omp parallel for schedule(static) private(j)
+	for ( i = 1 ; i < N-1 ; i++ )
+		for ( j = 1 ; j < N-1 ; j++ )
+			array[i][j] = random_cell(seed, i, j);
+}
+
+/*
+ * Pin the calling thread to a core: the tid-th entry of the comma
+ * separated MT_CONF cpu list if it is set, cpu tid otherwise.
+ */
+void pin_thread(int tid) {
+	cpu_set_t mask;
+	char * conf = getenv("MT_CONF"), * s, * tok, * save;
+	int cpu = tid, i = 0;
+
+	if ( conf ) {
+		s = strdup(conf);
+		for ( tok = strtok_r(s, ",", &save) ; tok ; tok = strtok_r(NULL, ",", &save), i++ )
+			if ( i == tid ) {
+				cpu = atoi(tok);
+				break;
+			}
+		free(s);
+	}
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	if ( sched_setaffinity(0, sizeof(mask), &mask) ) {
+		perror("sched_setaffinity");
+		exit(1);
+	}
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "util.h"
+#include "csr.h"
+
+/* Every entry of A off the diagonal that is not INF becomes an edge */
+struct csr *csr_from_matrix(const struct matrix *A)
+{
+	struct csr *G=(struct csr *)malloc(sizeof(*G));
+	int n=A->N, i, j, e, a;
+
+	G->n=n;
+	G->rowptr=(int *)malloc((n+1)*sizeof(int));
+	G->rowptr[0]=0;
+	for(i=0; i<n; i++){
+		e=0;
+		for(j=0; j<n; j++)
+			e+=j!=i && *matrix_at(A,i,j)<INF;
+		G->rowptr[i+1]=G->rowptr[i]+e;
+	}
+	G->m=G->rowptr[n];
+	G->col=(int *)malloc(G->m*sizeof(int));
+	G->w=(int *)malloc(G->m*sizeof(int));
+
+	#pragma omp parallel for private(j,e,a)
+	for(i=0; i<n; i++){
+		e=G->rowptr[i];
+		for(j=0; j<n; j++){
+			a=*matrix_at(A,i,j);
+			if(j!=i && a<INF){
+				G->col[e]=j;
+				G->w[e++]=a;
+			}
+		}
+	}
+	return G;
+}
+
+void csr_free(struct csr *G)
+{
+	free(G->rowptr);
+	free(G->col);
+	free(G->w);
+	free(G);
+}
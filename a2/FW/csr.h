@@ -0,0 +1,21 @@
+/*
+ * Graph in compressed sparse row form: the edges leaving u are
+ * col[rowptr[u]..rowptr[u+1]-1] with weights w[...].
+ */
+#ifndef CSR_H
+#define CSR_H
+
+#include "matrix.h"
+
+struct csr {
+	int n;
+	int m;
+	int *rowptr;	//n+1 entries
+	int *col;
+	int *w;
+};
+
+struct csr *csr_from_matrix(const struct matrix *A);
+void csr_free(struct csr *G);
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * All-pairs shortest paths on a sparse graph: Dijkstra from every source,
+ * the sources spread over OMP_NUM_THREADS threads.
+ * command line arguments: [-c] N
+ * N = size of graph
+ * -c = compare the distances with fw's loop on the same graph (fw_solve)
+ *
+ * The graph is the same one the fw programs build (dense, or sparse with
+ * FW_DEGREE=d), turned into CSR form before the timing starts. Weights
+ * are non-negative, so no Johnson reweighting is needed, and the distance
+ * matrix equals fw's (INF for unreachable pairs). Each thread has its own
+ * indexed binary heap with decrease-key, for O(m log n) per source.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "util.h"
+#include "csr.h"
+#include "incr.h"
+
+struct heap {
+	int n;
+	int *v;		//heap of vertices, ordered by dist
+	int *pos;	//index of each vertex in v, -1 if not in the heap
+	const int *dist;
+};
+
+void dijkstra(const struct csr *G, int s, int *dist, struct heap *H);
+
+int main(int argc, char **argv)
+{
+	struct matrix *M, *D;
+	struct csr *G;
+	int i,j,m,opt,do_check=0;
+	struct timeval t1, t2;
+	double time;
+	long bad;
+	int N=1024;
+
+	while((opt=getopt(argc, argv, "c"))!=-1){
+		if(opt=='c') do_check=1;
+		else argc=0;
+	}
+	if (argc-optind != 1) {
+		fprintf(stdout,"Usage: %s [-c] N\n", argv[0]);
+		exit(0);
+	}
+
+	N=atoi(argv[optind]);
+
+	M = matrix_alloc(N,0,MATRIX_ROW);
+	m = graph_init(M,-1,N);
+	G = csr_from_matrix(M);
+	matrix_free(M);
+	D = matrix_alloc(N,0,MATRIX_ROW);
+
+	gettimeofday(&t1,0);
+	#pragma omp parallel
+	{
+		struct heap H;
+
+		H.v = (int *) malloc(N*sizeof(int));
+		H.pos = (int *) malloc(N*sizeof(int));
+
+		#pragma omp for schedule(dynamic,16)
+		for(i=0; i<N; i++)
+			dijkstra(G, i, D->row[i], &H);
+
+		free(H.v);
+		free(H.pos);
+	}
+	gettimeofday(&t2,0);
+
+	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
+	printf("DIJKSTRA,%d,%d,%.4f\n", N, m, time);
+
+	if(do_check){
+		M = matrix_alloc(N,0,MATRIX_ROW);
+		graph_init(M,-1,N);
+		fw_solve(M);
+		bad=0;
+		for(i=0; i<N; i++)
+			for(j=0; j<N; j++)
+				bad+=D->row[i][j]!=M->row[i][j];
+		printf("CHECK,%s,%ld\n", bad ? "FAILED" : "OK", bad);
+		matrix_free(M);
+	}
+
+	csr_free(G);
+	matrix_free(D);
+	return 0;
+}
+
+static inline void heap_swap(struct heap *H, int a, int b)
+{
+	int t=H->v[a];
+
+	H->v[a]=H->v[b];
+	H->v[b]=t;
+	H->pos[H->v[a]]=a;
+	H->pos[H->v[b]]=b;
+}
+
+static void heap_up(struct heap *H, int i)
+{
+	while(i>0 && H->dist[H->v[(i-1)/2]] > H->dist[H->v[i]]){
+		heap_swap(H, i, (i-1)/2);
+		i=(i-1)/2;
+	}
+}
+
+static void heap_down(struct heap *H, int i)
+{
+	int c;
+
+	while((c=2*i+1) < H->n){
+		if(c+1 < H->n && H->dist[H->v[c+1]] < H->dist[H->v[c]]) c++;
+		if(H->dist[H->v[i]] <= H->dist[H->v[c]]) break;
+		heap_swap(H, i, c);
+		i=c;
+	}
+}
+
+static int heap_pop(struct heap *H)
+{
+	int u=H->v[0];
+
+	H->pos[u]=-1;
+	if(--H->n > 0){
+		H->v[0]=H->v[H->n];
+		H->pos[H->v[0]]=0;
+		heap_down(H, 0);
+	}
+	return u;
+}
+
+/* Distances from s into dist[0..n-1], INF where unreachable */
+void dijkstra(const struct csr *G, int s, int *dist, struct heap *H)
+{
+	int u,v,e,d;
+
+	for(v=0; v<G->n; v++){
+		dist[v]=INF;
+		H->pos[v]=-1;
+	}
+	H->dist=dist;
+	H->n=1;
+	H->v[0]=s;
+	H->pos[s]=0;
+	dist[s]=0;
+
+	while(H->n > 0){
+		u=heap_pop(H);
+		for(e=G->rowptr[u]; e<G->rowptr[u+1]; e++){
+			v=G->col[e];
+			d=dist[u]+G->w[e];
+			if(d >= dist[v]) continue;
+			dist[v]=d;
+			if(H->pos[v] < 0){
+				H->pos[v]=H->n;
+				H->v[H->n++]=v;
+			}
+			heap_up(H, H->pos[v]);
+		}
+	}
+}
@@ -11,6 +11,7 @@ inline int min(int a, int b);
 
 int main(int argc, char **argv)
 {
+	struct matrix *M;
 	int **A;
 	int i,j,k;
 	struct timeval t1, t2;
@@ -24,10 +25,10 @@ int main(int argc, char **argv)
 
 	N=atoi(argv[1]);
 
-	A = (int **) malloc(N*sizeof(int *));
-	for(i=0; i<N; i++) A[i] = (int *) malloc(N*sizeof(int));
+	M = matrix_alloc(N,0,MATRIX_ROW);
+	A = M->row;
 
-	graph_init_random(A,-1,N,128*N);
+	graph_init(M,-1,N);
 
 	gettimeofday(&t1,0);
 	for(k=0;k<N;k++)
@@ -38,13 +39,14 @@ int main(int argc, char **argv)
 	gettimeofday(&t2,0);
 
 	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
-	printf("FW,%d,%.4f\n", N, time);
+	printf("FW,%d,%s,%.4f\n", N, matrix_layout_name(M), time);
 
 	/*
 	   for(i=0; i<N; i++)
 	   for(j=0; j<N; j++) fprintf(stdout,"%d\n", A[i][j]);
 	 */
 
+	matrix_free(M);
 	return 0;     
 }
 
@@ -0,0 +1,160 @@
+/*
+ * Incremental Floyd-Warshall: solves the graph once, then applies batches
+ * of random edge weight changes with fw_update (see incr.c) and checks
+ * every batch against a full recompute.
+ * command line arguments: N [, batch sizes]
+ * N = size of graph
+ * batch sizes = edges changed per batch (default 1 10 100 1000 10000)
+ *
+ * Half of every batch are decreases of a random edge to below the current
+ * distance between its ends, so each one shortens at least that pair; the
+ * other half are increases of the cheapest edge leaving a random vertex,
+ * which is always on a shortest path. The check solves the new weights
+ * from scratch with fw's loop. Every batch is updated incrementally,
+ * whatever its size, so the two times show where a full solve gets
+ * cheaper; FW_FULL_RATIO=r in the environment lets fw_update fall back to
+ * a full solve above N/r changes, as it does by default (r=16).
+ * One line per batch:
+ * FW_INCR,N,batch,decreases,increases,rows changed by increases (-1: batch
+ * solved from scratch),update time,full time,errors
+ *
+ * Before the batches a fixed case with a zero-weight cycle through the
+ * source is checked the same way:
+ * FW_INCR_CHECK,zero-cycle,errors
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "util.h"
+#include "incr.h"
+
+static double now(void)
+{
+	struct timeval t;
+
+	gettimeofday(&t,0);
+	return t.tv_sec+t.tv_usec*1e-6;
+}
+
+/* n random changes, alternating decrease and increase */
+static void random_batch(const struct matrix *W, const struct matrix *D, struct edge_update *e, int n,
+			 int *dec, int *inc)
+{
+	int N=W->N, k, u, v, j;
+
+	*dec=*inc=0;
+	for(k=0; k<n; k++){
+		u=lrand48()%N;
+		if(k%2==0){
+			do v=lrand48()%N; while(v==u);
+			e[k].u=u;
+			e[k].v=v;
+			e[k].w=D->row[u][v]>0 ? lrand48()%D->row[u][v] : 0;
+			(*dec)++;
+			continue;
+		}
+		for(v=-1, j=0; j<N; j++)
+			if(j!=u && (v<0 || W->row[u][j]<W->row[u][v])) v=j;
+		e[k].u=u;
+		e[k].v=v;
+		e[k].w=W->row[u][v]>=INF-1048576 ? INF : W->row[u][v]+1+lrand48()%1048576;
+		(*inc)++;
+	}
+}
+
+/* Entries of D that differ from R */
+static long errors(const struct matrix *D, const struct matrix *R)
+{
+	long bad=0;
+	int i,j;
+
+	for(i=0; i<D->N; i++)
+		for(j=0; j<D->N; j++)
+			bad+=D->row[i][j]!=R->row[i][j];
+	return bad;
+}
+
+/* 0->1 and 1->0 weigh 0, 1->2 weighs 5, then 0->1 goes up to 1: rows 0 1 6 / 0 0 5 */
+static long zero_cycle_check(void)
+{
+	int N=32, i, j;
+	struct matrix *W=matrix_alloc(N,0,MATRIX_ROW), *D=matrix_alloc(N,0,MATRIX_ROW), *R=matrix_alloc(N,0,MATRIX_ROW);
+	struct edge_update e={0, 1, 1};
+	long bad;
+
+	for(i=0; i<N; i++)
+		for(j=0; j<N; j++)
+			W->row[i][j]=i==j ? 0 : INF;
+	W->row[0][1]=0;
+	W->row[1][0]=0;
+	W->row[1][2]=5;
+	memcpy(D->data, W->data, (size_t)N*N*sizeof(int));
+	fw_solve(D);
+	fw_update(W, D, &e, 1);
+	memcpy(R->data, W->data, (size_t)N*N*sizeof(int));
+	fw_solve(R);
+	bad=errors(D, R);
+
+	matrix_free(W);
+	matrix_free(D);
+	matrix_free(R);
+	return bad;
+}
+
+int main(int argc, char **argv)
+{
+	struct matrix *W, *D, *R;
+	struct edge_update *e;
+	int default_batches[]={1, 10, 100, 1000, 10000};
+	int *batches=default_batches, nbatches=5;
+	int N, b, dec, inc, rows;
+	double t, tu, tf;
+
+	if (argc < 2) {
+		fprintf(stdout,"Usage: %s N [batch sizes]\n", argv[0]);
+		exit(0);
+	}
+
+	N=atoi(argv[1]);
+	if (argc > 2) {
+		nbatches=argc-2;
+		batches=(int *)malloc(nbatches*sizeof(int));
+		for(b=0; b<nbatches; b++) batches[b]=atoi(argv[b+2]);
+	}
+
+	fw_full_ratio=getenv("FW_FULL_RATIO") ? atoi(getenv("FW_FULL_RATIO")) : 0;
+	printf("FW_INCR_CHECK,zero-cycle,%ld\n", zero_cycle_check());
+
+	W = matrix_alloc(N,0,MATRIX_ROW);
+	D = matrix_alloc(N,0,MATRIX_ROW);
+	R = matrix_alloc(N,0,MATRIX_ROW);
+	graph_init(W,-1,N);
+	memcpy(D->data, W->data, (size_t)N*N*sizeof(int));
+	fw_solve(D);
+	srand48(1);
+
+	for(b=0; b<nbatches; b++){
+		e=(struct edge_update *)malloc(batches[b]*sizeof(*e));
+		random_batch(W, D, e, batches[b], &dec, &inc);
+
+		t=now();
+		rows=fw_update(W, D, e, batches[b]);
+		tu=now()-t;
+
+		memcpy(R->data, W->data, (size_t)N*N*sizeof(int));
+		t=now();
+		fw_solve(R);
+		tf=now()-t;
+
+		printf("FW_INCR,%d,%d,%d,%d,%d,%.4f,%.4f,%ld\n", N, batches[b], dec, inc, rows, tu, tf, errors(D, R));
+		free(e);
+	}
+
+	matrix_free(W);
+	matrix_free(D);
+	matrix_free(R);
+	if(batches!=default_batches) free(batches);
+	return 0;
+}
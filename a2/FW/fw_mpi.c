@@ -0,0 +1,268 @@
+/*
+ * MPI version of the tiled Floyd-Warshall algorithm.
+ * usage: mpirun -np Px*Py ./fw_mpi [-c] N B Px Py
+ * N = size of graph
+ * B = size of tile
+ * Px x Py = process grid
+ * -c = gather the result on rank 0 and compare it with the serial fw loop
+ * works only when N is a multiple of B
+ *
+ * Tiles are dealt out 2D block-cyclically: tile (ib,jb) lives on the
+ * process at grid position (ib%Px, jb%Py). In step k the owner of the pivot
+ * tile updates it and broadcasts it along its grid row and column; those
+ * processes update their pivot row/column tiles, which are then broadcast
+ * down the grid columns (pivot row) and along the grid rows (pivot column)
+ * to everyone, and every process updates its remaining tiles.
+ *
+ * Lookahead: in step k each process first updates its tiles in tile row and
+ * column k+1, so step k+1's pivot, pivot row and column can be computed and
+ * their broadcasts started (MPI_Ibcast, into the second of two buffers)
+ * before the rest of step k's tiles are updated.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mpi.h>
+#include "util.h"
+#include "minplus.h"
+
+int N, B, NB, BB;
+int grid[2], me[2];		//process grid, and position in it
+int nlr, nlc;			//local tile rows and columns
+int *loc;			//local tiles, (li,lj) at loc+(li*nlc+lj)*BB
+int *piv;			//pivot tile of the current step
+int *rowbuf[2], *colbuf[2];	//pivot row/column tiles for local columns/rows, by step parity
+MPI_Comm ROW_COMM, COL_COMM;	//processes in my grid row / grid column
+MPI_Request req[2][2];		//row and column broadcasts, by step parity
+double tcomm=0;
+
+static inline int *tile(int ib, int jb)
+{
+	return loc+((size_t)(ib/grid[0])*nlc+jb/grid[1])*BB;
+}
+
+static inline int mine(int ib, int jb)
+{
+	return ib%grid[0]==me[0] && jb%grid[1]==me[1];
+}
+
+/* Update a local remainder tile (ib,jb) in step kb */
+static void update(int kb, int ib, int jb)
+{
+	int p=kb%2;
+
+	minplus(tile(ib,jb), colbuf[p]+(size_t)(ib/grid[0])*BB, rowbuf[p]+(size_t)(jb/grid[1])*BB, B, B);
+}
+
+/*
+ * Pivot and pivot row/column phases of step kb: tile row and column kb
+ * must be up to date with step kb-1. Ends with the broadcasts of the
+ * pivot row and column started.
+ */
+static void start_step(int kb)
+{
+	int p=kb%2, pr=kb%grid[0], pc=kb%grid[1];
+	int lj, li;
+	double t;
+
+	if(mine(kb,kb)){
+		minplus(tile(kb,kb), tile(kb,kb), tile(kb,kb), B, B);
+		memcpy(piv, tile(kb,kb), BB*sizeof(int));
+	}
+	t=MPI_Wtime();
+	if(me[0]==pr) MPI_Bcast(piv, BB, MPI_INT, pc, ROW_COMM);
+	if(me[1]==pc) MPI_Bcast(piv, BB, MPI_INT, pr, COL_COMM);
+	tcomm+=MPI_Wtime()-t;
+
+	if(me[0]==pr){
+		for(lj=0; lj<nlc; lj++){
+			if(lj*grid[1]+me[1]!=kb)
+				minplus(tile(kb,lj*grid[1]+me[1]), piv, tile(kb,lj*grid[1]+me[1]), B, B);
+			memcpy(rowbuf[p]+(size_t)lj*BB, tile(kb,lj*grid[1]+me[1]), BB*sizeof(int));
+		}
+	}
+	if(me[1]==pc){
+		for(li=0; li<nlr; li++){
+			if(li*grid[0]+me[0]!=kb)
+				minplus(tile(li*grid[0]+me[0],kb), tile(li*grid[0]+me[0],kb), piv, B, B);
+			memcpy(colbuf[p]+(size_t)li*BB, tile(li*grid[0]+me[0],kb), BB*sizeof(int));
+		}
+	}
+	MPI_Ibcast(rowbuf[p], nlc*BB, MPI_INT, pr, COL_COMM, &req[p][0]);
+	MPI_Ibcast(colbuf[p], nlr*BB, MPI_INT, pc, ROW_COMM, &req[p][1]);
+}
+
+/* Generate the graph of graph_init_random band by band, keeping my tiles */
+static void graph_local(void)
+{
+	int *band=(int *)malloc((size_t)B*N*sizeof(int));
+	int ib, jb, i;
+
+	srand48(-1);
+	for(ib=0; ib<NB; ib++){
+		graph_random_band(band, ib*B, B, N);
+		if(ib%grid[0]!=me[0]) continue;
+		for(jb=me[1]; jb<NB; jb+=grid[1])
+			for(i=0; i<B; i++)
+				memcpy(tile(ib,jb)+(size_t)i*B, band+(size_t)i*N+(size_t)jb*B, B*sizeof(int));
+	}
+	free(band);
+}
+
+/* Gather all tiles on rank 0 and compare them with fw's loop; returns the number of wrong entries */
+static long check(int rank, int size, MPI_Comm comm)
+{
+	struct matrix *M;
+	int **A;
+	int r, c[2], n[2], li, lj, ib, jb, i, j, k;
+	int *buf;
+	long bad=0;
+
+	if(rank){
+		MPI_Send(loc, nlr*nlc*BB, MPI_INT, 0, 0, comm);
+		return 0;
+	}
+	M=matrix_alloc(N,0,MATRIX_ROW);
+	A=M->row;
+	graph_init_random(M,-1,N,128*N);
+	for(k=0;k<N;k++)
+		for(i=0; i<N; i++)
+			for(j=0; j<N; j++)
+				A[i][j]=A[i][j]<=A[i][k]+A[k][j] ? A[i][j] : A[i][k]+A[k][j];
+
+	buf=(int *)malloc((size_t)((NB+grid[0]-1)/grid[0])*((NB+grid[1]-1)/grid[1])*BB*sizeof(int));
+	for(r=0; r<size; r++){
+		MPI_Cart_coords(comm, r, 2, c);
+		n[0]=(NB-c[0]+grid[0]-1)/grid[0];
+		n[1]=(NB-c[1]+grid[1]-1)/grid[1];
+		if(r)
+			MPI_Recv(buf, n[0]*n[1]*BB, MPI_INT, r, 0, comm, MPI_STATUS_IGNORE);
+		else
+			memcpy(buf, loc, (size_t)n[0]*n[1]*BB*sizeof(int));
+		for(li=0; li<n[0]; li++)
+			for(lj=0; lj<n[1]; lj++){
+				ib=li*grid[0]+c[0];
+				jb=lj*grid[1]+c[1];
+				for(i=0; i<B; i++)
+					for(j=0; j<B; j++)
+						bad+=buf[((size_t)li*n[1]+lj)*BB+i*B+j]!=A[ib*B+i][jb*B+j];
+			}
+	}
+	free(buf);
+	matrix_free(M);
+	return bad;
+}
+
+int main(int argc, char **argv)
+{
+	int rank, size, opt, do_check=0;
+	int periods[2]={0,0}, keep[2];
+	int kb, ib, jb, li, lj, p;
+	MPI_Comm CART_COMM;
+	double t1, t2, t;
+	const char *isa;
+	long bad;
+
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	while((opt=getopt(argc, argv, "c"))!=-1){
+		if(opt=='c') do_check=1;
+		else argc=0;
+	}
+	if(argc-optind!=4){
+		if(rank==0) fprintf(stderr, "Usage: mpirun -np Px*Py %s [-c] N B Px Py\n", argv[0]);
+		MPI_Finalize();
+		exit(0);
+	}
+	N=atoi(argv[optind]);
+	B=atoi(argv[optind+1]);
+	grid[0]=atoi(argv[optind+2]);
+	grid[1]=atoi(argv[optind+3]);
+	if(grid[0]*grid[1]!=size || B<=0 || N%B){
+		if(rank==0) fprintf(stderr, "need Px*Py == %d processes and N a multiple of B\n", size);
+		MPI_Finalize();
+		exit(1);
+	}
+	NB=N/B;
+	BB=B*B;
+
+	MPI_Cart_create(MPI_COMM_WORLD, 2, grid, periods, 0, &CART_COMM);
+	MPI_Comm_rank(CART_COMM, &rank);
+	MPI_Cart_coords(CART_COMM, rank, 2, me);
+	keep[0]=0; keep[1]=1;
+	MPI_Cart_sub(CART_COMM, keep, &ROW_COMM);	//rank in ROW_COMM is my grid column
+	keep[0]=1; keep[1]=0;
+	MPI_Cart_sub(CART_COMM, keep, &COL_COMM);	//rank in COL_COMM is my grid row
+
+	nlr=(NB-me[0]+grid[0]-1)/grid[0];
+	nlc=(NB-me[1]+grid[1]-1)/grid[1];
+	loc=(int *)malloc(((size_t)nlr*nlc+1)*BB*sizeof(int));
+	piv=(int *)malloc(BB*sizeof(int));
+	for(p=0; p<2; p++){
+		rowbuf[p]=(int *)malloc(((size_t)nlc+1)*BB*sizeof(int));
+		colbuf[p]=(int *)malloc(((size_t)nlr+1)*BB*sizeof(int));
+	}
+	graph_local();
+	isa=minplus_select();
+
+	MPI_Barrier(CART_COMM);
+	t1=MPI_Wtime();
+
+	start_step(0);
+	for(kb=0; kb<NB; kb++){
+		p=kb%2;
+		t=MPI_Wtime();
+		MPI_Waitall(2, req[p], MPI_STATUSES_IGNORE);
+		tcomm+=MPI_Wtime()-t;
+
+		//lookahead: tile row and column kb+1 first, then start step kb+1
+		if(kb+1<NB){
+			if((kb+1)%grid[0]==me[0])
+				for(lj=0; lj<nlc; lj++){
+					jb=lj*grid[1]+me[1];
+					if(jb!=kb) update(kb, kb+1, jb);
+				}
+			if((kb+1)%grid[1]==me[1])
+				for(li=0; li<nlr; li++){
+					ib=li*grid[0]+me[0];
+					if(ib!=kb && ib!=kb+1) update(kb, ib, kb+1);
+				}
+			start_step(kb+1);
+		}
+
+		for(li=0; li<nlr; li++){
+			ib=li*grid[0]+me[0];
+			if(ib==kb || ib==kb+1) continue;
+			for(lj=0; lj<nlc; lj++){
+				jb=lj*grid[1]+me[1];
+				if(jb==kb || jb==kb+1) continue;
+				update(kb, ib, jb);
+			}
+			if(kb+1<NB)		//let the step kb+1 broadcasts progress
+				MPI_Testall(2, req[1-p], &opt, MPI_STATUSES_IGNORE);
+		}
+	}
+
+	MPI_Barrier(CART_COMM);
+	t2=MPI_Wtime();
+	if(rank==0)
+		printf("FW_MPI,%d,%d,%d,%d,%s,%.4f,%.4f\n", N, B, grid[0], grid[1], isa, t2-t1, tcomm);
+
+	if(do_check){
+		bad=check(rank, size, CART_COMM);
+		if(rank==0)
+			printf("CHECK,%s,%ld\n", bad ? "FAILED" : "OK", bad);
+	}
+
+	free(loc);
+	free(piv);
+	for(p=0; p<2; p++){
+		free(rowbuf[p]);
+		free(colbuf[p]);
+	}
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * Out-of-core version of the tiled Floyd-Warshall algorithm, for graphs
+ * whose matrix does not fit in memory.
+ * command-line arguments: N, B, F [, C]
+ * N = size of graph
+ * B = size of tile
+ * F = file holding the matrix, tile-major (see matrix.h); it is created,
+ *     and holds the distances at the end
+ * C = tile cache size in MB (default 1024), at least 3*N/B tiles
+ * works only when N is a multiple of B
+ *
+ * The k-steps are those of fw_tiled: pivot tile, pivot row and column
+ * tiles, then the remaining tiles one tile row at a time. Tiles are read
+ * and written with pread/pwrite through a cache of C MB: the pivot row and
+ * column stay pinned during their step, everything else is evicted least
+ * recently used first, and dirty tiles are written back on eviction.
+ * While a tile row is computed (OMP_NUM_THREADS threads), the next one is
+ * read ahead with POSIX aio, and during the last tile row of a step so are
+ * the pivot row and column of the next step.
+ *
+ * Reports the compute time, the time spent waiting for I/O and the bytes
+ * read and written next to the total.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <aio.h>
+#include <sys/time.h>
+#include "util.h"
+#include "minplus.h"
+
+struct slot {
+	int tile;		//ib*NB+jb, -1: empty
+	int *data;
+	int dirty;
+	int pinned;
+	int loading;		//aio read in flight
+	int ahead;		//read ahead and not used yet
+	long used;		//LRU stamp
+	struct aiocb cb;
+};
+
+struct cache {
+	int fd;
+	int B, NB;
+	size_t tile_bytes;
+	int nslots;
+	struct slot *slot;
+	int *where;		//slot of each tile, -1 if not cached
+	long clock;
+	long long bytes_read, bytes_written;
+	double io_wait;
+};
+
+static double now(void)
+{
+	struct timeval t;
+
+	gettimeofday(&t,0);
+	return t.tv_sec+t.tv_usec*1e-6;
+}
+
+static void fail(const char *what)
+{
+	perror(what);
+	exit(1);
+}
+
+static void cache_write(struct cache *c, struct slot *s)
+{
+	double t=now();
+
+	if(pwrite(c->fd, s->data, c->tile_bytes, (off_t)s->tile*c->tile_bytes)!=(ssize_t)c->tile_bytes)
+		fail("pwrite");
+	c->bytes_written+=c->tile_bytes;
+	s->dirty=0;
+	c->io_wait+=now()-t;
+}
+
+static void cache_wait(struct cache *c, struct slot *s)
+{
+	const struct aiocb *list[1]={&s->cb};
+	double t=now();
+
+	while(aio_error(&s->cb)==EINPROGRESS)
+		aio_suspend(list, 1, NULL);
+	if(aio_return(&s->cb)!=(ssize_t)c->tile_bytes){
+		fprintf(stderr, "aio_read of tile %d failed\n", s->tile);
+		exit(1);
+	}
+	s->loading=0;
+	c->bytes_read+=c->tile_bytes;
+	c->io_wait+=now()-t;
+}
+
+/*
+ * Least recently used slot that is neither pinned nor being read, emptied;
+ * NULL if none. Tiles read ahead and not used yet go last, or a tile row
+ * read ahead would be the first to go while the row before it is computed.
+ */
+static struct slot *cache_victim(struct cache *c)
+{
+	struct slot *s, *v=NULL;
+	int i;
+
+	for(i=0; i<c->nslots; i++){
+		s=&c->slot[i];
+		if(s->pinned || s->loading) continue;
+		if(s->tile<0) return s;
+		if(!v || s->ahead<v->ahead || (s->ahead==v->ahead && s->used<v->used)) v=s;
+	}
+	if(v){
+		if(v->dirty) cache_write(c, v);
+		c->where[v->tile]=-1;
+		v->tile=-1;
+		v->ahead=0;
+	}
+	return v;
+}
+
+/* Start reading tile (ib,jb) in the background, unless it is cached or the cache is full */
+static void cache_prefetch(struct cache *c, int ib, int jb)
+{
+	int t=ib*c->NB+jb;
+	struct slot *s;
+
+	if(c->where[t]>=0 || !(s=cache_victim(c)))
+		return;
+	memset(&s->cb, 0, sizeof(s->cb));
+	s->cb.aio_fildes=c->fd;
+	s->cb.aio_buf=s->data;
+	s->cb.aio_nbytes=c->tile_bytes;
+	s->cb.aio_offset=(off_t)t*c->tile_bytes;
+	if(aio_read(&s->cb))
+		fail("aio_read");
+	s->tile=t;
+	s->loading=1;
+	s->ahead=1;
+	s->used=++c->clock;
+	c->where[t]=s-c->slot;
+}
+
+/* Tile (ib,jb), pinned until cache_release; reads it now if it was not prefetched */
+static int *cache_acquire(struct cache *c, int ib, int jb)
+{
+	int t=ib*c->NB+jb, i;
+	struct slot *s;
+	double w;
+
+	if(c->where[t]>=0){
+		s=&c->slot[c->where[t]];
+		if(s->loading) cache_wait(c, s);
+	}
+	else {
+		if(!(s=cache_victim(c))){
+			//only reads ahead left to evict: let them land
+			for(i=0; i<c->nslots; i++)
+				if(c->slot[i].loading) cache_wait(c, &c->slot[i]);
+			if(!(s=cache_victim(c))){
+				fprintf(stderr, "tile cache too small\n");
+				exit(1);
+			}
+		}
+		w=now();
+		if(pread(c->fd, s->data, c->tile_bytes, (off_t)t*c->tile_bytes)!=(ssize_t)c->tile_bytes)
+			fail("pread");
+		c->bytes_read+=c->tile_bytes;
+		c->io_wait+=now()-w;
+		s->tile=t;
+		c->where[t]=s-c->slot;
+	}
+	s->pinned++;
+	s->ahead=0;
+	s->used=++c->clock;
+	return s->data;
+}
+
+static void cache_release(struct cache *c, int ib, int jb, int dirty)
+{
+	struct slot *s=&c->slot[c->where[ib*c->NB+jb]];
+
+	s->pinned--;
+	s->dirty|=dirty;
+}
+
+/* Write back every dirty tile */
+static void cache_flush(struct cache *c)
+{
+	int i;
+
+	for(i=0; i<c->nslots; i++){
+		if(c->slot[i].loading) cache_wait(c, &c->slot[i]);
+		if(c->slot[i].tile>=0 && c->slot[i].dirty) cache_write(c, &c->slot[i]);
+	}
+}
+
+/* Write the random graph to the file, tile-major, one tile row (B matrix rows) at a time */
+static void graph_write(int fd, int N, int B)
+{
+	int NB=N/B, ib, jb, i;
+	int *band=(int *)malloc((size_t)B*N*sizeof(int));
+	int *tile=(int *)malloc((size_t)B*B*sizeof(int));
+	size_t tile_bytes=(size_t)B*B*sizeof(int);
+
+	srand48(-1);
+	for(ib=0; ib<NB; ib++){
+		graph_random_band(band, ib*B, B, N);
+		for(jb=0; jb<NB; jb++){
+			for(i=0; i<B; i++)
+				memcpy(tile+(size_t)i*B, band+(size_t)i*N+(size_t)jb*B, B*sizeof(int));
+			if(pwrite(fd, tile, tile_bytes, ((off_t)ib*NB+jb)*tile_bytes)!=(ssize_t)tile_bytes)
+				fail("pwrite");
+		}
+	}
+	free(band);
+	free(tile);
+}
+
+int main(int argc, char **argv)
+{
+	struct cache C;
+	int B=64;
+	int N=1024;
+	int NB, MB=1024;
+	int ib, jb, kb, nb, i;
+	int *P, **R, **Col, **X;	//pivot, pivot row and column, current tile row
+	double t1, t2, tc, compute=0;
+	const char *isa;
+
+	if (argc != 4 && argc != 5){
+		fprintf(stdout, "Usage %s N B file [cacheMB]\n", argv[0]);
+		exit(0);
+	}
+
+	N=atoi(argv[1]);
+	B=atoi(argv[2]);
+	if (argc == 5) MB=atoi(argv[4]);
+	if (B<=0 || N%B){
+		fprintf(stderr, "N=%d is not a multiple of B=%d\n", N, B);
+		exit(1);
+	}
+	NB=N/B;
+
+	memset(&C, 0, sizeof(C));
+	C.B=B;
+	C.NB=NB;
+	C.tile_bytes=(size_t)B*B*sizeof(int);
+	C.nslots=((size_t)MB<<20)/C.tile_bytes;
+	if (C.nslots>NB*NB) C.nslots=NB*NB;
+	if (C.nslots<3*NB && C.nslots<NB*NB){
+		fprintf(stderr, "a %d MB cache holds %d tiles, %d are needed\n", MB, C.nslots, 3*NB);
+		exit(1);
+	}
+	C.slot=(struct slot *)calloc(C.nslots, sizeof(struct slot));
+	for(i=0; i<C.nslots; i++){
+		C.slot[i].tile=-1;
+		if(posix_memalign((void **)&C.slot[i].data, MATRIX_ALIGN, C.tile_bytes))
+			fail("posix_memalign");
+	}
+	C.where=(int *)malloc(NB*NB*sizeof(int));
+	for(i=0; i<NB*NB; i++) C.where[i]=-1;
+	R=(int **)malloc(NB*sizeof(int *));
+	Col=(int **)malloc(NB*sizeof(int *));
+	X=(int **)malloc(NB*sizeof(int *));
+
+	C.fd=open(argv[3], O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if (C.fd<0) fail(argv[3]);
+	graph_write(C.fd, N, B);
+	fsync(C.fd);
+	isa=minplus_select();
+
+	t1=now();
+	for(kb=0; kb<NB; kb++){
+		P=cache_acquire(&C, kb, kb);
+		tc=now();
+		minplus(P, P, P, B, B);
+		compute+=now()-tc;
+
+		for(jb=0; jb<NB; jb++)
+			if(jb!=kb){
+				R[jb]=cache_acquire(&C, kb, jb);
+				Col[jb]=cache_acquire(&C, jb, kb);
+			}
+		tc=now();
+		#pragma omp parallel for schedule(dynamic)
+		for(i=0; i<2*NB; i++){
+			if(i/2==kb) continue;
+			if(i%2)
+				minplus(R[i/2], P, R[i/2], B, B);
+			else
+				minplus(Col[i/2], Col[i/2], P, B, B);
+		}
+		compute+=now()-tc;
+		cache_release(&C, kb, kb, 1);
+
+		for(ib=0; ib<NB; ib++){
+			if(ib==kb) continue;
+
+			//read ahead: the next tile row, or the next step's pivot row and column
+			nb=ib+1==kb ? ib+2 : ib+1;
+			if(nb<NB)
+				for(jb=0; jb<NB; jb++){
+					if(jb!=kb) cache_prefetch(&C, nb, jb);
+				}
+			else if(kb+1<NB)
+				for(jb=0; jb<NB; jb++){
+					cache_prefetch(&C, kb+1, jb);
+					cache_prefetch(&C, jb, kb+1);
+				}
+
+			for(jb=0; jb<NB; jb++)
+				if(jb!=kb) X[jb]=cache_acquire(&C, ib, jb);
+			tc=now();
+			#pragma omp parallel for schedule(dynamic)
+			for(jb=0; jb<NB; jb++)
+				if(jb!=kb) minplus(X[jb], Col[ib], R[jb], B, B);
+			compute+=now()-tc;
+			for(jb=0; jb<NB; jb++)
+				if(jb!=kb) cache_release(&C, ib, jb, 1);
+		}
+
+		for(jb=0; jb<NB; jb++)
+			if(jb!=kb){
+				cache_release(&C, kb, jb, 1);
+				cache_release(&C, jb, kb, 1);
+			}
+	}
+	cache_flush(&C);
+	if (fsync(C.fd)) fail("fsync");
+	t2=now();
+
+	printf("FW_OOC,%d,%d,%d,%s,%.4f,%.4f,%.4f,%.3f,%.3f\n", N, B, MB, isa, t2-t1, compute, C.io_wait,
+	       C.bytes_read/1e9, C.bytes_written/1e9);
+
+	close(C.fd);
+	for(i=0; i<C.nslots; i++) free(C.slot[i].data);
+	free(C.slot);
+	free(C.where);
+	free(R);
+	free(Col);
+	free(X);
+	return 0;
+}
@@ -1,90 +1,204 @@
 /*
  * Recursive implementation of the Floyd-Warshall algorithm.
- * command line arguments: N, B
+ * command line arguments: [-c] N, B [, D]
  * N = size of graph
- * B = size of submatrix when recursion stops
+ * B = size of submatrix when recursion stops, or auto / tune (see below)
+ * D = recursion depth below which no more tasks are spawned (default 4)
+ * -c = compare the distances with fw's loop on the same graph (fw_solve);
+ *      with FW_PATHS also follow the next hops of every reachable pair and
+ *      check that the path ends at j and its weights add up to the distance
  * works only for N, B = 2^k
+ *
+ * Of the eight recursive calls, the 2nd/3rd and the 6th/7th update
+ * different quadrants from data the other one does not write, so each
+ * pair runs as two OpenMP tasks (OMP_NUM_THREADS threads) followed by
+ * a taskwait. The order of updates of every element is unchanged.
+ *
+ * With FW_PATHS set in the environment a next-hop matrix is kept too
+ * (see path.h) and the path from 0 to N-1 is printed after the timing.
+ *
+ * B = auto takes B and D tuned for this kernel and thread count from the
+ * host's tuning file (see tune.h), and tunes them first if there are none;
+ * B = tune always tunes. Tuning times a 1024 node run without next hops
+ * for every B that tune_block_sizes allows, then depths 0..6 with the best
+ * B. A D on the command line overrides the tuned one.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/time.h>
 #include "util.h"
+#include "minplus.h"
+#include "path.h"
+#include "tune.h"
+#include "incr.h"
 
-inline int min(int a, int b);
 void FW_SR (int **A, int arow, int acol, 
             int **B, int brow, int bcol, 
             int **C, int crow, int ccol, 
-            int myN, int bsize);
+            int myN, int bsize, int depth);
+static double trial(int B, int D);
+static long check(const struct matrix *M, const struct matrix *NH);
+
+int cutoff=4;
+int ld;		//row stride of A, B and C
+int **P;	//next-hop matrix, same offsets as A, or NULL
 
 int main(int argc, char **argv)
 {
+	struct matrix *M;
+	struct matrix *NH=NULL;
 	int **A;
-	int i,j;
+	const char *isa;
+	char key[64];
+	int Bs[TUNE_MAX], Ds[]={4,0,1,2,3,5,6}, D;
+	int opt,do_check=0;
 	struct timeval t1, t2;
 	double time;
+	long bad;
 	int B=16;
 	int N=1024;
 
-	if (argc !=3){
-		fprintf(stdout, "Usage %s N B \n", argv[0]);
+	while((opt=getopt(argc, argv, "c"))!=-1){
+		if(opt=='c') do_check=1;
+		else argc=0;
+	}
+	argc-=optind-1;
+	argv+=optind-1;
+	if (argc !=3 && argc !=4){
+		fprintf(stdout, "Usage %s [-c] N B [D]\n", argv[0]);
 		exit(0);
 	}
 
 	N=atoi(argv[1]);
-	B=atoi(argv[2]);
+	isa = minplus_select();
+	if (!strcmp(argv[2],"auto") || !strcmp(argv[2],"tune")) {
+		sprintf(key,"fw_sr/%s",isa);
+		tune_get(key,!strcmp(argv[2],"tune"),Bs,tune_block_sizes(Bs),Ds,7,trial,&B,&cutoff);
+		if (B > N) B = N;
+	}
+	else
+		B=atoi(argv[2]);
+	if (argc == 4) cutoff=atoi(argv[3]);
 
-	A = (int **) malloc(N*sizeof(int *));
-	for(i=0; i<N; i++) A[i] = (int *) malloc(N*sizeof(int));
+	M = matrix_alloc(N,0,MATRIX_ROW);
+	A = M->row;
+	ld = matrix_ld(M);
 
-	graph_init_random(A,-1,N,128*N);
+	graph_init(M,-1,N);
+	if (getenv("FW_PATHS")) {
+		NH = matrix_alloc(N,0,MATRIX_ROW);
+		path_init(NH);
+		P = NH->row;
+	}
 
 	gettimeofday(&t1,0);
-	FW_SR(A,0,0, A,0,0,A,0,0,N,B);
+	#pragma omp parallel
+	#pragma omp single
+	FW_SR(A,0,0, A,0,0,A,0,0,N,B,0);
 	gettimeofday(&t2,0);
 
 	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
-	printf("FW_SR,%d,%d,%.4f\n", N, B, time);
+	printf("FW_SR,%d,%d,%d,%s,%s,%d,%.4f\n", N, B, cutoff, matrix_layout_name(M), isa, NH!=NULL, time);
+	if (NH) path_print(NH,M,0,N-1);
 
-	/*
-	   for(i=0; i<N; i++)
-	   for(j=0; j<N; j++) fprintf(stdout,"%d\n", A[i][j]);
-	 */
+	if (do_check) {
+		bad = check(M,NH);
+		printf("CHECK,%s,%ld\n", bad ? "FAILED" : "OK", bad);
+	}
 
+	matrix_free(M);
+	if (NH) matrix_free(NH);
 	return 0;
 }
 
-inline int min(int a, int b)
+/*
+ * Entries of M that differ from fw's loop on the same graph, plus the pairs
+ * whose path along the next hops NH (if any) does not reach j or does not
+ * add up to the distance in M
+ */
+static long check(const struct matrix *M, const struct matrix *NH)
+{
+	struct matrix *W, *R;
+	int N=M->N, i, j, k, n;
+	int *path=(int *)malloc(N*sizeof(int));
+	long bad=0, len;
+
+	W = matrix_alloc(N,0,MATRIX_ROW);
+	R = matrix_alloc(N,0,MATRIX_ROW);
+	graph_init(W,-1,N);
+	graph_init(R,-1,N);
+	fw_solve(R);
+
+	for(i=0; i<N; i++)
+		for(j=0; j<N; j++){
+			bad+=M->row[i][j]!=R->row[i][j];
+			if(!NH || M->row[i][j]>=INF) continue;
+			n=path_get(NH,i,j,path,N);
+			for(len=0, k=1; k<n; k++) len+=W->row[path[k-1]][path[k]];
+			bad+=n<1 || len!=M->row[i][j];
+		}
+
+	free(path);
+	matrix_free(W);
+	matrix_free(R);
+	return bad;
+}
+
+/* Seconds per cell update of a 1024 node graph with base case B and cutoff D */
+static double trial(int B, int D)
 {
-	if(a<=b)return a;
-	else return b;
+	struct matrix *M = matrix_alloc(1024,0,MATRIX_ROW);
+	struct timeval t1, t2;
+	double time;
+	int saved = cutoff;
+
+	graph_init_random(M,-1,1024,128*1024);
+	ld = matrix_ld(M);
+	cutoff = D;
+	gettimeofday(&t1,0);
+	#pragma omp parallel
+	#pragma omp single
+	FW_SR(M->row,0,0, M->row,0,0,M->row,0,0,1024,B,0);
+	gettimeofday(&t2,0);
+	cutoff = saved;
+	matrix_free(M);
+	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
+	return time/1024/1024/1024;
 }
 
 void FW_SR (int **A, int arow, int acol, 
             int **B, int brow, int bcol, 
             int **C, int crow, int ccol, 
-            int myN, int bsize)
+            int myN, int bsize, int depth)
 {
-	int k,i,j;
-
 	/*
-	 * The base case (when recursion stops) is not allowed to be edited!
-	 * What you can do is try different block sizes.
+	 * The base case (when recursion stops) is the original
+	 *   A[arow+i][acol+j]=min(A[arow+i][acol+j], B[brow+i][bcol+k]+C[crow+k][ccol+j])
+	 * loop over k, i, j < myN, done by the min-plus kernel.
 	 */
-	if(myN<=bsize)
-		for(k=0; k<myN; k++)
-			for(i=0; i<myN; i++)
-				for(j=0; j<myN; j++)
-					A[arow+i][acol+j]=min(A[arow+i][acol+j], B[brow+i][bcol+k]+C[crow+k][ccol+j]);
+	if(myN<=bsize && P)
+		minplus_path(&A[arow][acol], &B[brow][bcol], &C[crow][ccol],
+			     &P[arow][acol], &P[brow][bcol], ld, myN);
+	else if(myN<=bsize)
+		minplus(&A[arow][acol], &B[brow][bcol], &C[crow][ccol], ld, myN);
 	else {
-		FW_SR(A,arow, acol,B,brow, bcol,C,crow, ccol, myN/2, bsize);
-		FW_SR(A,arow, acol+myN/2,B,brow, bcol,C,crow, ccol+myN/2, myN/2, bsize);
-		FW_SR(A,arow+myN/2, acol,B,brow+myN/2, bcol,C,crow, ccol, myN/2, bsize);
-		FW_SR(A,arow+myN/2, acol+myN/2,B,brow+myN/2, bcol,C,crow, ccol+myN/2, myN/2, bsize);
-		FW_SR(A,arow+myN/2, acol+myN/2,B,brow+myN/2, bcol+myN/2,C,crow+myN/2, ccol+myN/2, myN/2, bsize);
-		FW_SR(A,arow+myN/2, acol,B,brow+myN/2, bcol+myN/2,C,crow+myN/2, ccol, myN/2, bsize);
-		FW_SR(A,arow, acol+myN/2,B,brow, bcol+myN/2,C,crow+myN/2, ccol+myN/2, myN/2, bsize);
-		FW_SR(A,arow, acol,B,brow, bcol+myN/2,C,crow+myN/2, ccol, myN/2, bsize);
+		FW_SR(A,arow, acol,B,brow, bcol,C,crow, ccol, myN/2, bsize, depth+1);
+		#pragma omp task if(depth<cutoff)
+		FW_SR(A,arow, acol+myN/2,B,brow, bcol,C,crow, ccol+myN/2, myN/2, bsize, depth+1);
+		#pragma omp task if(depth<cutoff)
+		FW_SR(A,arow+myN/2, acol,B,brow+myN/2, bcol,C,crow, ccol, myN/2, bsize, depth+1);
+		#pragma omp taskwait
+		FW_SR(A,arow+myN/2, acol+myN/2,B,brow+myN/2, bcol,C,crow, ccol+myN/2, myN/2, bsize, depth+1);
+		FW_SR(A,arow+myN/2, acol+myN/2,B,brow+myN/2, bcol+myN/2,C,crow+myN/2, ccol+myN/2, myN/2, bsize, depth+1);
+		#pragma omp task if(depth<cutoff)
+		FW_SR(A,arow+myN/2, acol,B,brow+myN/2, bcol+myN/2,C,crow+myN/2, ccol, myN/2, bsize, depth+1);
+		#pragma omp task if(depth<cutoff)
+		FW_SR(A,arow, acol+myN/2,B,brow, bcol+myN/2,C,crow+myN/2, ccol+myN/2, myN/2, bsize, depth+1);
+		#pragma omp taskwait
+		FW_SR(A,arow, acol,B,brow, bcol+myN/2,C,crow+myN/2, ccol, myN/2, bsize, depth+1);
 	}
 }
 
@@ -1,99 +1,172 @@
 /*
  * Tiled version of the Floyd-Warshall algorithm.
- * command-line arguments: N, B
+ * command-line arguments: N, B [, L]
  * N = size of graph
- * B = size of tile
+ * B = size of tile, or auto / tune (see below)
+ * L = matrix layout, row (default) or tile (each tile contiguous)
  * works only when N is a multiple of B
+ *
+ * Every tile update is an OpenMP task (OMP_NUM_THREADS threads). Each
+ * tile has a dependency token, and a task depends on the tokens of the
+ * tiles it reads (in) and writes (inout):
+ *   pivot (k,k):          inout (k,k)
+ *   row/column (k,j),(i,k): in (k,k), inout own tile
+ *   remainder (i,j):      in (i,k), in (k,j), inout (i,j)
+ * so there is no barrier between phases or k-steps: row and column tiles
+ * run in parallel as soon as the pivot is done, and the pivot of step k+1
+ * starts as soon as the tiles it needs from step k are.
+ *
+ * With FW_PATHS set in the environment a next-hop matrix is kept too
+ * (see path.h) and the path from 0 to N-1 is printed after the timing.
+ *
+ * B = auto takes the tile size tuned for this layout, kernel and thread
+ * count from the host's tuning file (see tune.h), and tunes it first if
+ * there is none; B = tune always tunes. Tuning times a short run without
+ * next hops for every power of two that tune_block_sizes allows; the
+ * divisor of N nearest to the result is used.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include "util.h"
+#include "minplus.h"
+#include "path.h"
+#include "tune.h"
 
-inline int min(int a, int b);
-inline void FW(int **A, int K, int I, int J, int N);
+static inline void FW(struct matrix *M, struct matrix *P, int K, int I, int J, int N);
+static void fw_tiled(struct matrix *M, struct matrix *P, int B);
+static double trial(int B, int D);
+
+static int layout=MATRIX_ROW;
 
 int main(int argc, char **argv)
 {
-	int **A;
-	int i,j,k;
+	struct matrix *M;
+	struct matrix *P=NULL;	//next-hop matrix, with FW_PATHS
+	const char *isa;
+	char key[64];
+	int Bs[TUNE_MAX], D;
+	int i,j;
 	struct timeval t1, t2;
 	double time;
 	int B=64;
 	int N=1024;
 
-	if (argc != 3){
-		fprintf(stdout, "Usage %s N B\n", argv[0]);
+	if ((argc != 3 && argc != 4) || (argc == 4 && (layout=matrix_parse_layout(argv[3])) < 0)){
+		fprintf(stdout, "Usage %s N B [row|tile]\n", argv[0]);
 		exit(0);
 	}
 
 	N=atoi(argv[1]);
-	B=atoi(argv[2]);
+	isa=minplus_select();
+	if(!strcmp(argv[2],"auto") || !strcmp(argv[2],"tune")){
+		sprintf(key,"fw_tiled/%s/%s",layout==MATRIX_TILE ? "tile" : "row",isa);
+		tune_get(key,!strcmp(argv[2],"tune"),Bs,tune_block_sizes(Bs),NULL,0,trial,&B,&D);
+		B=tune_divisor(N,B);
+	}
+	else
+		B=atoi(argv[2]);
 
-	A=(int **)malloc(N*sizeof(int *));
-	for(i=0; i<N; i++)A[i]=(int *)malloc(N*sizeof(int));
+	M=matrix_alloc(N,B,layout);
 
-	graph_init_random(A,-1,N,128*N);
+	graph_init(M,-1,N);
+	if(getenv("FW_PATHS")){
+		P=matrix_alloc(N,B,layout);
+		path_init(P);
+	}
 
 	gettimeofday(&t1,0);
-
-	for(k=0;k<N;k+=B){
-		FW(A,k,k,k,B);
-
-		for(i=0; i<k; i+=B)
-			FW(A,k,i,k,B);
-
-		for(i=k+B; i<N; i+=B)
-			FW(A,k,i,k,B);
-
-		for(j=0; j<k; j+=B)
-			FW(A,k,k,j,B);
-
-		for(j=k+B; j<N; j+=B)
-			FW(A,k,k,j,B);
-
-		for(i=0; i<k; i+=B)
-			for(j=0; j<k; j+=B)
-				FW(A,k,i,j,B);
-
-		for(i=0; i<k; i+=B)
-			for(j=k+B; j<N; j+=B)
-				FW(A,k,i,j,B);
-
-		for(i=k+B; i<N; i+=B)
-			for(j=0; j<k; j+=B)
-				FW(A,k,i,j,B);
-
-		for(i=k+B; i<N; i+=B)
-			for(j=k+B; j<N; j+=B)
-				FW(A,k,i,j,B);
-	}
+	fw_tiled(M,P,B);
 	gettimeofday(&t2,0);
 
 	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
-	printf("FW_TILED,%d,%d,%.4f\n", N,B,time);
+	printf("FW_TILED,%d,%d,%s,%s,%d,%.4f\n", N,B,matrix_layout_name(M),isa,P!=NULL,time);
+	if(P) path_print(P,M,0,N-1);
 
 	/*
 	   for(i=0; i<N; i++)
-	   for(j=0; j<N; j++) fprintf(stdout,"%d\n", A[i][j]);
+	   for(j=0; j<N; j++) fprintf(stdout,"%d\n", *matrix_at(M,i,j));
 	 */
 
+	matrix_free(M);
+	if(P) matrix_free(P);
 	return 0;
 }
 
-inline int min(int a, int b)
+/* All k-steps on M (and P if not NULL) with B x B tiles, as dependent tasks */
+static void fw_tiled(struct matrix *M, struct matrix *P, int B)
 {
-	if(a<=b)return a;
-	else return b;
+	int N=M->N, NB=N/B;
+	int i,j,k;
+	char *T;		//dependency token of tile (i,j) is T[i*NB+j]
+
+	T=(char *)malloc(NB*NB);
+
+	#pragma omp parallel
+	#pragma omp single
+	for(k=0;k<N;k+=B){
+		int kb=k/B, ib, jb;
+
+		#pragma omp task firstprivate(k) depend(inout: T[kb*NB+kb])
+		FW(M,P,k,k,k,B);
+
+		for(i=0; i<N; i+=B){
+			if(i==k) continue;
+			ib=i/B;
+			#pragma omp task firstprivate(k,i) depend(in: T[kb*NB+kb]) depend(inout: T[ib*NB+kb])
+			FW(M,P,k,i,k,B);
+		}
+
+		for(j=0; j<N; j+=B){
+			if(j==k) continue;
+			jb=j/B;
+			#pragma omp task firstprivate(k,j) depend(in: T[kb*NB+kb]) depend(inout: T[kb*NB+jb])
+			FW(M,P,k,k,j,B);
+		}
+
+		for(i=0; i<N; i+=B){
+			if(i==k) continue;
+			ib=i/B;
+			for(j=0; j<N; j+=B){
+				if(j==k) continue;
+				jb=j/B;
+				#pragma omp task firstprivate(k,i,j) depend(in: T[ib*NB+kb], T[kb*NB+jb]) depend(inout: T[ib*NB+jb])
+				FW(M,P,k,i,j,B);
+			}
+		}
+	}
+	free(T);
 }
 
-inline void FW(int **A, int K, int I, int J, int N)
+/* Seconds per cell update of a 4B (at least 1024) node graph with B x B tiles */
+static double trial(int B, int D)
 {
-	int i,j,k;
+	int n=4*B<1024 ? 1024 : 4*B;
+	struct matrix *M=matrix_alloc(n,B,layout);
+	struct timeval t1, t2;
+	double time;
 
-	for(k=K; k<K+N; k++)
-		for(i=I; i<I+N; i++)
-			for(j=J; j<J+N; j++)
-				A[i][j]=min(A[i][j], A[i][k]+A[k][j]);
+	graph_init_random(M,-1,n,128*n);
+	gettimeofday(&t1,0);
+	fw_tiled(M,NULL,B);
+	gettimeofday(&t2,0);
+	matrix_free(M);
+	time=(double)((t2.tv_sec-t1.tv_sec)*1000000+t2.tv_usec-t1.tv_usec)/1000000;
+	return time/n/n/n;
+}
 
+/*
+ * Update tile (I,J) of M through the pivot tiles (I,K) and (K,J), and the
+ * same tiles of the next-hop matrix P if there is one.
+ * Each tile is addressed from its first element with stride ld, so the
+ * same kernel serves both layouts.
+ */
+static inline void FW(struct matrix *M, struct matrix *P, int K, int I, int J, int N)
+{
+	if(P)
+		minplus_path(matrix_at(M,I,J), matrix_at(M,I,K), matrix_at(M,K,J),
+			     matrix_at(P,I,J), matrix_at(P,I,K), matrix_ld(M), N);
+	else
+		minplus(matrix_at(M,I,J), matrix_at(M,I,K), matrix_at(M,K,J), matrix_ld(M), N);
 }
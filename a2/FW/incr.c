@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util.h"
+#include "incr.h"
+
+/* Batches of more than N/fw_full_ratio changes are solved from scratch; 0: never */
+int fw_full_ratio=16;
+
+/*
+ * Solve D from scratch: fw's loop, the rows of each step in parallel.
+ * Row k cannot change in step k (D[k][k] is 0) and the other rows read
+ * it, so it is skipped rather than rewritten with its own values.
+ */
+void fw_solve(struct matrix *D)
+{
+	int **A=D->row, N=D->N;
+	int i,j,k,aik;
+
+	for(k=0;k<N;k++)
+		#pragma omp parallel for private(j,aik)
+		for(i=0; i<N; i++){
+			if(i==k) continue;
+			aik=A[i][k];
+			for(j=0; j<N; j++)
+				A[i][j]=A[i][j]<=aik+A[k][j] ? A[i][j] : aik+A[k][j];
+		}
+}
+
+/*
+ * Edge u->v got shorter (weight w): a pair (i,j) can only improve through
+ * it if D[i][u]+w < D[i][v] and w+D[v][j] < D[u][j], so only those rows
+ * and columns are visited. Row v and column u never change, so the rows
+ * can be updated in place in parallel.
+ */
+static void decrease(struct matrix *D, int u, int v, int w, int *rows, int *cols)
+{
+	int **A=D->row, N=D->N;
+	int i, j, ni=0, nj=0, x;
+
+	for(i=0; i<N; i++)
+		if(A[i][u]<INF && A[i][u]+w<A[i][v]) rows[ni++]=i;
+	for(j=0; j<N; j++)
+		if(A[v][j]<INF && w+A[v][j]<A[u][j]) cols[nj++]=j;
+
+	#pragma omp parallel for private(j,x) schedule(static)
+	for(i=0; i<ni; i++){
+		int *Ai=A[rows[i]], diu=Ai[u]+w;
+		for(j=0; j<nj; j++){
+			x=diu+A[v][cols[j]];
+			if(x<Ai[cols[j]]) Ai[cols[j]]=x;
+		}
+	}
+}
+
+/*
+ * Row i after the increases inc[0..ninc-1] (edge u->v, old weight orig),
+ * with W already holding the new weights and D still the old distances.
+ * The entries that can change are the j with a shortest path through an
+ * increased edge, D[i][u]+orig+D[v][j] == D[i][j]; every other entry has
+ * a shortest path that avoids them all and keeps its value. The changed
+ * ones are seeded from the unchanged ones over one edge, then settled by
+ * Dijkstra among themselves: O(N) per changed entry instead of O(N^2) per
+ * row. D[i][i] is 0 before and after and is never one of them, even when
+ * a zero-weight cycle through i makes it look like one. Stores the changed
+ * entries in *list and their new values in *val, returns how many there are.
+ */
+static int increase_row(const struct matrix *W, const struct matrix *D, int i,
+			const struct edge_update *inc, const int *orig, int ninc,
+			int *tight, char *aff, int **list, int **val)
+{
+	int N=D->N, k, t, nt=0, n=0, j, x, y, best, *L, *d;
+	const int *Di=D->row[i], *Wx;
+
+	for(k=0; k<ninc; k++)
+		if(Di[inc[k].u]<INF && Di[inc[k].u]+orig[k]==Di[inc[k].v]) tight[nt++]=k;
+	if(!nt)
+		return 0;
+
+	L=(int *)malloc(N*sizeof(int));
+	for(j=0; j<N; j++){
+		aff[j]=0;
+		for(t=0; t<nt && !aff[j] && j!=i; t++){
+			x=inc[tight[t]].v;
+			aff[j]=D->row[x][j]<INF && Di[x]+D->row[x][j]==Di[j];
+		}
+		if(aff[j]) L[n++]=j;
+	}
+	if(!n){
+		free(L);
+		return 0;
+	}
+
+	d=(int *)malloc(n*sizeof(int));
+	for(k=0; k<n; k++) d[k]=INF;
+	for(x=0; x<N; x++){
+		if(aff[x] || Di[x]>=INF) continue;
+		Wx=W->row[x];
+		for(k=0; k<n; k++)
+			if(Wx[L[k]]<INF && Di[x]+Wx[L[k]]<d[k]) d[k]=Di[x]+Wx[L[k]];
+	}
+	//Dijkstra over the changed entries: settled ones are moved to the front
+	for(t=0; t<n; t++){
+		best=t;
+		for(k=t+1; k<n; k++)
+			if(d[k]<d[best]) best=k;
+		x=L[best]; L[best]=L[t]; L[t]=x;
+		y=d[best]; d[best]=d[t]; d[t]=y;
+		if(y>=INF) break;
+		Wx=W->row[x];
+		for(k=t+1; k<n; k++)
+			if(Wx[L[k]]<INF && y+Wx[L[k]]<d[k]) d[k]=y+Wx[L[k]];
+	}
+	*list=L;
+	*val=d;
+	return n;
+}
+
+/*
+ * Apply the batch e[0..n-1] to the weights W and update the distances D
+ * (both N x N, row-major, D solved for W). Returns the number of rows
+ * that changed because of increases, or -1 if the batch had more than
+ * N/fw_full_ratio changes and was solved again from scratch.
+ *
+ * Increases go first, all at once and in parallel over the rows (see
+ * increase_row). Then the decreases are applied one after the other, each
+ * in O(N^2) at worst.
+ */
+int fw_update(struct matrix *W, struct matrix *D, const struct edge_update *e, int n)
+{
+	int N=D->N, k, i, ninc, rows=0;
+	int *orig, *neww, *old, *count, **list, **val;
+	struct edge_update *inc;
+	int *buf;
+
+	if(fw_full_ratio && n>N/fw_full_ratio){
+		for(k=0; k<n; k++) W->row[e[k].u][e[k].v]=e[k].w;
+		memcpy(D->data, W->data, (size_t)N*N*sizeof(int));
+		fw_solve(D);
+		return -1;
+	}
+	orig=(int *)malloc(n*sizeof(int));
+	neww=(int *)malloc(n*sizeof(int));
+	inc=(struct edge_update *)malloc(n*sizeof(*inc));
+	old=(int *)malloc(n*sizeof(int));
+	count=(int *)calloc(N, sizeof(int));
+	list=(int **)malloc(N*sizeof(int *));
+	val=(int **)malloc(N*sizeof(int *));
+	buf=(int *)malloc(2*N*sizeof(int));
+
+	//net change of every entry: weight before the batch and after all of it
+	for(k=0; k<n; k++){
+		orig[k]=W->row[e[k].u][e[k].v];
+		W->row[e[k].u][e[k].v]=e[k].w;
+	}
+	for(k=0; k<n; k++) neww[k]=W->row[e[k].u][e[k].v];
+	for(k=n-1; k>=0; k--) W->row[e[k].u][e[k].v]=orig[k];
+	for(k=0; k<n; k++) orig[k]=W->row[e[k].u][e[k].v];
+
+	ninc=0;
+	for(k=0; k<n; k++)
+		if(neww[k]>orig[k]){
+			inc[ninc]=e[k];
+			inc[ninc].w=neww[k];
+			old[ninc++]=orig[k];
+			W->row[e[k].u][e[k].v]=neww[k];
+		}
+
+	if(ninc){
+		#pragma omp parallel
+		{
+			int *tight=(int *)malloc(ninc*sizeof(int));
+			char *aff=(char *)malloc(N);
+
+			#pragma omp for schedule(dynamic,16)
+			for(i=0; i<N; i++)
+				count[i]=increase_row(W, D, i, inc, old, ninc, tight, aff, &list[i], &val[i]);
+			free(tight);
+			free(aff);
+		}
+		//all rows were computed from the old D, now they can be written back
+		for(i=0; i<N; i++){
+			if(!count[i]) continue;
+			rows++;
+			for(k=0; k<count[i]; k++) D->row[i][list[i][k]]=val[i][k];
+			free(list[i]);
+			free(val[i]);
+		}
+	}
+
+	for(k=0; k<n; k++)
+		if(neww[k]<orig[k] && W->row[e[k].u][e[k].v]>neww[k]){
+			W->row[e[k].u][e[k].v]=neww[k];
+			decrease(D, e[k].u, e[k].v, neww[k], buf, buf+N);
+		}
+
+	free(orig);
+	free(neww);
+	free(inc);
+	free(old);
+	free(count);
+	free(list);
+	free(val);
+	free(buf);
+	return rows;
+}
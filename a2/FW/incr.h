@@ -0,0 +1,21 @@
+/*
+ * Incremental all-pairs shortest paths: bring a solved distance matrix up
+ * to date after a batch of edge weight changes, touching only the pairs
+ * the changes can affect.
+ */
+#ifndef INCR_H
+#define INCR_H
+
+#include "matrix.h"
+
+/* Edge u->v gets weight w (INF removes it). Later entries for the same edge win. */
+struct edge_update {
+	int u, v, w;
+};
+
+extern int fw_full_ratio;
+
+int fw_update(struct matrix *W, struct matrix *D, const struct edge_update *e, int n);
+void fw_solve(struct matrix *D);
+
+#endif
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix.h"
+
+struct matrix *matrix_alloc(int N, int B, int layout)
+{
+	struct matrix *M;
+	int i;
+
+	if(layout==MATRIX_TILE && (B<=0 || N%B)){
+		fprintf(stderr, "matrix_alloc: N=%d is not a multiple of B=%d\n", N, B);
+		exit(1);
+	}
+
+	M=(struct matrix *)calloc(1, sizeof(*M));
+	M->N=N;
+	M->B=B;
+	M->layout=layout;
+	if(posix_memalign((void **)&M->data, MATRIX_ALIGN, (size_t)N*N*sizeof(int))){
+		perror("matrix_alloc");
+		exit(1);
+	}
+	if(layout==MATRIX_ROW){
+		M->row=(int **)malloc(N*sizeof(int *));
+		for(i=0; i<N; i++) M->row[i]=M->data+(size_t)i*N;
+	}
+	return M;
+}
+
+void matrix_free(struct matrix *M)
+{
+	free(M->row);
+	free(M->data);
+	free(M);
+}
+
+/* "row" or "tile", -1 for anything else */
+int matrix_parse_layout(const char *s)
+{
+	if(!strcmp(s, "row")) return MATRIX_ROW;
+	if(!strcmp(s, "tile")) return MATRIX_TILE;
+	return -1;
+}
+
+const char *matrix_layout_name(const struct matrix *M)
+{
+	return M->layout==MATRIX_TILE ? "tile" : "row";
+}
@@ -0,0 +1,49 @@
+/*
+ * N x N distance matrix in one aligned allocation.
+ *
+ * MATRIX_ROW:  row-major, row[i] points at row i, so A[i][j] code works
+ *              unchanged on it.
+ * MATRIX_TILE: tile-major, the B x B tiles are stored one after the other
+ *              in row-major tile order and each tile is row-major inside,
+ *              so a tile is contiguous. N must be a multiple of B.
+ *
+ * matrix_at(M,i,j) points at element (i,j); the rest of the B x B tile
+ * that starts there (or of the row, for MATRIX_ROW) is reached with the
+ * stride matrix_ld(M).
+ */
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#define MATRIX_ROW	0
+#define MATRIX_TILE	1
+
+#define MATRIX_ALIGN	64
+
+struct matrix {
+	int N;
+	int B;		//tile size, MATRIX_TILE only
+	int layout;
+	int *data;
+	int **row;	//row pointers, MATRIX_ROW only
+};
+
+struct matrix *matrix_alloc(int N, int B, int layout);
+void matrix_free(struct matrix *M);
+int matrix_parse_layout(const char *s);
+const char *matrix_layout_name(const struct matrix *M);
+
+static inline int matrix_ld(const struct matrix *M)
+{
+	return M->layout==MATRIX_TILE ? M->B : M->N;
+}
+
+static inline int *matrix_at(const struct matrix *M, int i, int j)
+{
+	int B=M->B;
+
+	if(M->layout==MATRIX_TILE)
+		return M->data + ((size_t)(i/B)*(M->N/B) + j/B)*B*B + (i%B)*B + j%B;
+	return M->data + (size_t)i*M->N + j;
+}
+
+#endif
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "minplus.h"
+
+/*
+ * The vector kernels are blocked over 4 rows of a: for each k the row
+ * c[k] is loaded once per vector and used for all 4 rows, each with its
+ * own broadcast b[i][k]. Columns past the last full vector and rows past
+ * the last block of 4 are done by the scalar loop.
+ */
+
+static inline int min(int a, int b)
+{
+	return a<=b ? a : b;
+}
+
+static inline void minplus_row(int *a, int bik, const int *ck, int j, int n)
+{
+	for(; j<n; j++)
+		a[j]=min(a[j], bik+ck[j]);
+}
+
+static void minplus_scalar(int *a, const int *b, const int *c, int ld, int n)
+{
+	int i,k;
+
+	for(k=0; k<n; k++)
+		for(i=0; i<n; i++)
+			minplus_row(a+(size_t)i*ld, b[(size_t)i*ld+k], c+(size_t)k*ld, 0, n);
+}
+
+/* Path kernels: where b[i][k]+c[k][j] is strictly shorter, na[i][j]=nb[i][k] */
+static inline void minplus_path_row(int *a, int *na, int bik, int nbik, const int *ck, int j, int n)
+{
+	int s, lt;
+
+	for(; j<n; j++){
+		s=bik+ck[j];
+		lt=-(s<a[j]);
+		a[j]=min(a[j], s);
+		na[j]=(na[j]&~lt)|(nbik&lt);
+	}
+}
+
+static void minplus_path_scalar(int *a, const int *b, const int *c, int *na, const int *nb, int ld, int n)
+{
+	int i,k;
+
+	for(k=0; k<n; k++)
+		for(i=0; i<n; i++)
+			minplus_path_row(a+(size_t)i*ld, na+(size_t)i*ld, b[(size_t)i*ld+k], nb[(size_t)i*ld+k],
+					 c+(size_t)k*ld, 0, n);
+}
+
+#define MINPLUS_VECTOR(name, isa, W, vec, set1, load, store, add, minv, done)	\
+__attribute__((target(isa)))							\
+static void name(int *a, const int *b, const int *c, int ld, int n)		\
+{										\
+	int i,j,k,r;								\
+	int *a0,*a1,*a2,*a3;							\
+	const int *ck;								\
+	vec b0,b1,b2,b3,cv;							\
+										\
+	for(k=0; k<n; k++){							\
+		ck=c+(size_t)k*ld;						\
+		for(i=0; i+4<=n; i+=4){						\
+			a0=a+(size_t)i*ld; a1=a0+ld; a2=a1+ld; a3=a2+ld;	\
+			b0=set1(b[(size_t)i*ld+k]);				\
+			b1=set1(b[(size_t)(i+1)*ld+k]);				\
+			b2=set1(b[(size_t)(i+2)*ld+k]);				\
+			b3=set1(b[(size_t)(i+3)*ld+k]);				\
+			for(j=0; j+W<=n; j+=W){					\
+				cv=load((void *)(ck+j));			\
+				store((void *)(a0+j), minv(load((void *)(a0+j)), add(b0,cv)));	\
+				store((void *)(a1+j), minv(load((void *)(a1+j)), add(b1,cv)));	\
+				store((void *)(a2+j), minv(load((void *)(a2+j)), add(b2,cv)));	\
+				store((void *)(a3+j), minv(load((void *)(a3+j)), add(b3,cv)));	\
+			}							\
+			for(r=0; r<4; r++)					\
+				minplus_row(a+(size_t)(i+r)*ld, b[(size_t)(i+r)*ld+k], ck, j, n);	\
+		}								\
+		for(; i<n; i++)							\
+			minplus_row(a+(size_t)i*ld, b[(size_t)i*ld+k], ck, 0, n);	\
+	}									\
+	done;									\
+}
+
+MINPLUS_VECTOR(minplus_avx2, "avx2", 8, __m256i, _mm256_set1_epi32,
+	       _mm256_loadu_si256, _mm256_storeu_si256, _mm256_add_epi32, _mm256_min_epi32,
+	       _mm256_zeroupper())
+MINPLUS_VECTOR(minplus_avx512, "avx512f", 16, __m512i, _mm512_set1_epi32,
+	       _mm512_loadu_si512, _mm512_storeu_si512, _mm512_add_epi32, _mm512_min_epi32,
+	       _mm256_zeroupper())
+
+/* One vector of a row: a=min(a,b+c), nx=blend(nx,nb) where that was shorter */
+__attribute__((target("avx2")))
+static inline void path_avx2(int *a, int *nx, __m256i b, __m256i nb, __m256i c)
+{
+	__m256i av=_mm256_loadu_si256((void *)a), s=_mm256_add_epi32(b, c);
+	__m256i lt=_mm256_cmpgt_epi32(av, s);
+
+	_mm256_storeu_si256((void *)a, _mm256_min_epi32(av, s));
+	_mm256_storeu_si256((void *)nx, _mm256_blendv_epi8(_mm256_loadu_si256((void *)nx), nb, lt));
+}
+
+__attribute__((target("avx512f")))
+static inline void path_avx512(int *a, int *nx, __m512i b, __m512i nb, __m512i c)
+{
+	__m512i av=_mm512_loadu_si512(a), s=_mm512_add_epi32(b, c);
+	__mmask16 lt=_mm512_cmplt_epi32_mask(s, av);
+
+	_mm512_storeu_si512(a, _mm512_min_epi32(av, s));
+	_mm512_mask_storeu_epi32(nx, lt, nb);
+}
+
+#define MINPLUS_PATH_VECTOR(name, isa, W, vec, set1, load, update, done)	\
+__attribute__((target(isa)))							\
+static void name(int *a, const int *b, const int *c, int *na, const int *nb, int ld, int n)	\
+{										\
+	int i,j,k,r;								\
+	size_t o0,o1,o2,o3;							\
+	const int *ck;								\
+	vec b0,b1,b2,b3,n0,n1,n2,n3,cv;						\
+										\
+	for(k=0; k<n; k++){							\
+		ck=c+(size_t)k*ld;						\
+		for(i=0; i+4<=n; i+=4){						\
+			o0=(size_t)i*ld; o1=o0+ld; o2=o1+ld; o3=o2+ld;		\
+			b0=set1(b[o0+k]); n0=set1(nb[o0+k]);			\
+			b1=set1(b[o1+k]); n1=set1(nb[o1+k]);			\
+			b2=set1(b[o2+k]); n2=set1(nb[o2+k]);			\
+			b3=set1(b[o3+k]); n3=set1(nb[o3+k]);			\
+			for(j=0; j+W<=n; j+=W){					\
+				cv=load((void *)(ck+j));			\
+				update(a+o0+j, na+o0+j, b0, n0, cv);		\
+				update(a+o1+j, na+o1+j, b1, n1, cv);		\
+				update(a+o2+j, na+o2+j, b2, n2, cv);		\
+				update(a+o3+j, na+o3+j, b3, n3, cv);		\
+			}							\
+			for(r=0; r<4; r++)					\
+				minplus_path_row(a+o0+(size_t)r*ld, na+o0+(size_t)r*ld,	\
+						 b[o0+(size_t)r*ld+k], nb[o0+(size_t)r*ld+k], ck, j, n);	\
+		}								\
+		for(; i<n; i++)							\
+			minplus_path_row(a+(size_t)i*ld, na+(size_t)i*ld,	\
+					 b[(size_t)i*ld+k], nb[(size_t)i*ld+k], ck, 0, n);	\
+	}									\
+	done;									\
+}
+
+MINPLUS_PATH_VECTOR(minplus_path_avx2, "avx2", 8, __m256i, _mm256_set1_epi32,
+		    _mm256_loadu_si256, path_avx2, _mm256_zeroupper())
+MINPLUS_PATH_VECTOR(minplus_path_avx512, "avx512f", 16, __m512i, _mm512_set1_epi32,
+		    _mm512_loadu_si512, path_avx512, _mm256_zeroupper())
+
+static const struct {
+	const char *name;
+	const char *feature;		//for __builtin_cpu_supports, NULL: always
+	minplus_kernel kernel;
+	minplus_path_kernel path;	//same, keeping the next-hop matrix
+} kernels[] = {
+	{ "avx512", "avx512f", minplus_avx512, minplus_path_avx512 },
+	{ "avx2", "avx2", minplus_avx2, minplus_path_avx2 },
+	{ "scalar", NULL, minplus_scalar, minplus_path_scalar },
+};
+
+#define NKERNELS (sizeof(kernels)/sizeof(kernels[0]))
+
+minplus_kernel minplus=minplus_scalar;
+minplus_path_kernel minplus_path=minplus_path_scalar;
+
+static int cpu_has(const char *feature)
+{
+	__builtin_cpu_init();
+	if(feature==NULL)
+		return 1;
+	if(!strcmp(feature, "avx512f"))
+		return __builtin_cpu_supports("avx512f");
+	if(!strcmp(feature, "avx2"))
+		return __builtin_cpu_supports("avx2");
+	return 0;
+}
+
+const char *minplus_select(void)
+{
+	char *isa=getenv("FW_ISA");
+	unsigned int k;
+
+	for(k=0; k<NKERNELS; k++){
+		if(isa && strcmp(isa, kernels[k].name))
+			continue;
+		if(cpu_has(kernels[k].feature)){
+			minplus=kernels[k].kernel;
+			minplus_path=kernels[k].path;
+			return kernels[k].name;
+		}
+		if(isa){
+			fprintf(stderr, "FW_ISA=%s is not supported by this cpu\n", isa);
+			exit(1);
+		}
+	}
+	if(isa){
+		fprintf(stderr, "FW_ISA=%s: unknown kernel\n", isa);
+		exit(1);
+	}
+	return "scalar";
+}
@@ -0,0 +1,34 @@
+/*
+ * Min-plus update of an n x n block, the inner loop of every Floyd-Warshall
+ * variant here:
+ *
+ *	for k, i, j < n:  a[i][j] = min(a[i][j], b[i][k] + c[k][j])
+ *
+ * with all three blocks addressed from their first element with row
+ * stride ld. a may be the same block as b and/or c (diagonal and pivot
+ * row/column updates), as in Floyd-Warshall row and column k do not
+ * change in step k.
+ *
+ * minplus_path() does the same and also keeps the next-hop blocks na and
+ * nb of a and b (same stride): where b[i][k] + c[k][j] is strictly shorter than
+ * a[i][j], na[i][j] becomes nb[i][k], the first hop from i towards k.
+ * The update is branch free (compare, then blend), so ties keep the old
+ * hop and the result does not depend on the kernel.
+ *
+ * minplus_select() picks the widest kernel the cpu supports, or the one
+ * named by the FW_ISA environment variable (avx512, avx2, scalar), and
+ * returns its name.
+ */
+#ifndef MINPLUS_H
+#define MINPLUS_H
+
+typedef void (*minplus_kernel)(int *a, const int *b, const int *c, int ld, int n);
+typedef void (*minplus_path_kernel)(int *a, const int *b, const int *c,
+				    int *na, const int *nb, int ld, int n);
+
+extern minplus_kernel minplus;
+extern minplus_path_kernel minplus_path;
+
+const char *minplus_select(void);
+
+#endif
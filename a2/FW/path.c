@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "util.h"
+#include "path.h"
+
+void path_init(struct matrix *P)
+{
+	int i,j;
+
+	#pragma omp parallel for private(j)
+	for(i=0; i<P->N; i++)
+		for(j=0; j<P->N; j++)
+			*matrix_at(P,i,j)=j;
+}
+
+/*
+ * Store the vertices of the shortest path from i to j, both included,
+ * in path[0..] and return their number, or -1 if there are more than max.
+ * Takes O(path length).
+ */
+int path_get(const struct matrix *P, int i, int j, int *path, int max)
+{
+	int n=0;
+
+	if(max<1) return -1;
+	path[n++]=i;
+	while(i!=j){
+		if(n==max) return -1;
+		i=*matrix_at(P,i,j);
+		path[n++]=i;
+	}
+	return n;
+}
+
+/* PATH,i,j,distance,vertices separated by spaces (none if j is unreachable) */
+void path_print(const struct matrix *P, const struct matrix *D, int i, int j)
+{
+	int *path=(int *)malloc(P->N*sizeof(int));
+	int n,v;
+
+	n=*matrix_at(D,i,j)<INF ? path_get(P,i,j,path,P->N) : 0;
+	printf("PATH,%d,%d,%d,", i, j, *matrix_at(D,i,j));
+	for(v=0; v<n; v++)
+		printf(v ? " %d" : "%d", path[v]);
+	printf("\n");
+	free(path);
+}
@@ -0,0 +1,19 @@
+/*
+ * Shortest path reconstruction from a next-hop matrix P kept alongside
+ * the distance matrix: P[i][j] is the vertex after i on a shortest path
+ * from i to j. path_init() sets P[i][j]=j for every pair, the direct
+ * edge, and minplus_path() overwrites it whenever a path through k is
+ * shorter. A pair that is unreachable (distance INF) is never improved,
+ * so it keeps P[i][j]=j and path_get() would return the bogus path i j;
+ * check the distance first, as path_print() does.
+ */
+#ifndef PATH_H
+#define PATH_H
+
+#include "matrix.h"
+
+void path_init(struct matrix *P);
+int path_get(const struct matrix *P, int i, int j, int *path, int max);
+void path_print(const struct matrix *P, const struct matrix *D, int i, int j);
+
+#endif
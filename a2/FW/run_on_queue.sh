@@ -19,6 +19,36 @@
 module load openmp
 cd <FIX_PATH>
 export OMP_NUM_THREADS=8
+# export FW_ISA=avx2		# min-plus kernel of fw_sr/fw_tiled: avx512, avx2 or scalar (default: widest supported)
+# export FW_PATHS=1		# fw_sr/fw_tiled also keep next hops and print the path from 0 to N-1
 ./fw <SIZE>
-# ./fw_sr <SIZE> <BSIZE>
-# ./fw_tiled <SIZE> <BSIZE>
+# ./fw_sr <SIZE> <BSIZE> <DEPTH>
+# ./fw_sr -c <SIZE> <BSIZE> <DEPTH>	# same distances as fw's loop? (and valid paths with FW_PATHS)
+# ./fw_tiled <SIZE> <BSIZE> [row|tile]
+
+## Tuned block sizes: auto uses (or first finds) the best B (and D) for this host and
+## OMP_NUM_THREADS, kept in ~/.fw_tune-<hostname>; tune re-runs the search
+# export FW_TUNE_FILE=$HOME/fw_tune.txt	# tuning file shared by hosts of the same kind
+# ./fw_tiled <SIZE> auto tile
+# ./fw_sr <SIZE> auto
+# ./fw_tiled <SIZE> tune tile
+
+## Speedup curve of the task-parallel tiled version (ppn above must match the largest count)
+# for t in 1 2 4 8 16 32 64; do OMP_NUM_THREADS=$t ./fw_tiled <SIZE> <BSIZE>; done
+# for t in 1 2 4 8 16 32 64; do OMP_NUM_THREADS=$t ./fw_sr <SIZE> <BSIZE> <DEPTH>; done
+
+## Sparse graphs: average out-degree d instead of a dense matrix, for every program
+# export FW_DEGREE=10
+# ./dijkstra <SIZE>
+# ./dijkstra -c <SIZE>	# same distances as fw's loop?
+# for d in 10 30 100 300 1000; do FW_DEGREE=$d ./fw_tiled <SIZE> <BSIZE> tile; FW_DEGREE=$d ./dijkstra <SIZE>; done
+
+## Out of core: matrix in a file on local scratch, tile cache of <CACHE_MB> MB
+# ./fw_ooc <SIZE> <BSIZE> /tmp/fw_ooc.bin <CACHE_MB>
+
+## MPI (make fw_mpi): Px x Py processes, -c checks the result against the serial loop on rank 0
+# module load openmpi
+# mpirun -np 8 ./fw_mpi <SIZE> <BSIZE> 2 4
+
+## Incremental updates: batches of edge changes against a full recompute
+# ./fw_incr <SIZE> 1 10 100 1000 10000
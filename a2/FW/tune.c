@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+#include "tune.h"
+
+/* Timed runs per candidate, after one warm-up run */
+#define TUNE_REPS	3
+
+/*
+ * Data cache sizes in bytes (L1, L2, last level): sysconf, or the cpu0
+ * entries under /sys where sysconf does not know them.
+ */
+void tune_caches(long cache[3])
+{
+	char path[128], type[32], size[32];
+	int i, level;
+	long n;
+	FILE *f;
+
+	cache[0]=sysconf(_SC_LEVEL1_DCACHE_SIZE);
+	cache[1]=sysconf(_SC_LEVEL2_CACHE_SIZE);
+	cache[2]=sysconf(_SC_LEVEL3_CACHE_SIZE);
+	for(i=0; i<8; i++){
+		sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+		if(!(f=fopen(path, "r"))) break;
+		level=0;
+		if(fscanf(f, "%d", &level)!=1) level=0;
+		fclose(f);
+		sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+		if(!(f=fopen(path, "r"))) continue;
+		if(fscanf(f, "%31s", type)!=1 || !strcmp(type, "Instruction")) level=0;
+		fclose(f);
+		sprintf(path, "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+		if(!(f=fopen(path, "r"))) continue;
+		if(fscanf(f, "%31s", size)==1 && level>=1 && level<=3 && cache[level-1]<=0){
+			n=atol(size);
+			if(strchr(size, 'K')) n<<=10;
+			if(strchr(size, 'M')) n<<=20;
+			cache[level-1]=n;
+		}
+		fclose(f);
+	}
+	if(cache[0]<=0) cache[0]=32<<10;
+	if(cache[1]<=0) cache[1]=1<<20;
+	if(cache[2]<=0) cache[2]=cache[1];
+}
+
+/*
+ * Candidate block sizes: powers of two from 16 up to the first one whose
+ * three int tiles (the ones a tile update touches) no longer fit in L2.
+ */
+int tune_block_sizes(int *Bs)
+{
+	long cache[3];
+	int n=0, B;
+
+	tune_caches(cache);
+	for(B=16; n<TUNE_MAX; B*=2){
+		Bs[n++]=B;
+		if(3L*B*B*sizeof(int)>cache[1]) break;
+	}
+	return n;
+}
+
+/* The divisor of n nearest to B by ratio, for programs that need whole tiles */
+int tune_divisor(int n, int B)
+{
+	int d, best=n;
+	double r, rbest=0;
+
+	for(d=1; d<=n; d++){
+		if(n%d) continue;
+		r=d>B ? (double)d/B : (double)B/d;
+		if(d==1 || r<rbest){
+			rbest=r;
+			best=d;
+		}
+	}
+	return best;
+}
+
+static void tune_path(char *path, size_t len)
+{
+	char host[64]="localhost";
+	char *home=getenv("HOME");
+
+	if(getenv("FW_TUNE_FILE")){
+		snprintf(path, len, "%s", getenv("FW_TUNE_FILE"));
+		return;
+	}
+	gethostname(host, sizeof(host));
+	host[sizeof(host)-1]=0;
+	snprintf(path, len, "%s/.fw_tune-%s", home ? home : ".", host);
+}
+
+/* Best of TUNE_REPS runs, so a trial slowed down by noise does not decide */
+static double tune_time(tune_trial trial, int B, int D)
+{
+	double t, best=0;
+	int r;
+
+	for(r=0; r<TUNE_REPS; r++){
+		t=trial(B, D);
+		if(r==0 || t<best) best=t;
+	}
+	return best;
+}
+
+/*
+ * B and D for key: from the tuning file unless force is set, otherwise the
+ * fastest B of Bs[0..nB-1] with cutoff Ds[0], then the fastest D of
+ * Ds[0..nD-1] with that B. One warm-up run (page faults, clock ramp-up)
+ * is thrown away first, then every candidate is timed TUNE_REPS times and
+ * its best time, reported on stderr, is what counts. nD may be 0 (D is
+ * then 0).
+ */
+void tune_get(const char *key, int force, const int *Bs, int nB, const int *Ds, int nD,
+	      tune_trial trial, int *B, int *D)
+{
+	char path[512], line[256], k[128];
+	int threads=omp_get_max_threads(), th, b, d, i, found=0;
+	double t, best;
+	FILE *f;
+
+	tune_path(path, sizeof(path));
+	if(!force && (f=fopen(path, "r"))){
+		while(fgets(line, sizeof(line), f))
+			if(sscanf(line, "%127s %d %d %d", k, &th, &b, &d)==4 && !strcmp(k, key) && th==threads){
+				*B=b;
+				*D=d;
+				found=1;
+			}
+		fclose(f);
+		if(found) return;
+	}
+
+	*D=nD ? Ds[0] : 0;
+	trial(Bs[0], *D);
+	for(i=0, best=0; i<nB; i++){
+		t=tune_time(trial, Bs[i], *D);
+		fprintf(stderr, "TUNE,%s,%d,%d,%d,%.3e\n", key, threads, Bs[i], *D, t);
+		if(i==0 || t<best){
+			best=t;
+			*B=Bs[i];
+		}
+	}
+	for(i=1; i<nD; i++){
+		t=tune_time(trial, *B, Ds[i]);
+		fprintf(stderr, "TUNE,%s,%d,%d,%d,%.3e\n", key, threads, *B, Ds[i], t);
+		if(t<best){
+			best=t;
+			*D=Ds[i];
+		}
+	}
+
+	if((f=fopen(path, "a"))){
+		fprintf(f, "%s %d %d %d\n", key, threads, *B, *D);
+		fclose(f);
+	}
+	else
+		perror(path);
+}
@@ -0,0 +1,25 @@
+/*
+ * Block size autotuning. A program names what it tunes with a key (program,
+ * layout, kernel) and gives a trial function; tune_get() returns the block
+ * size B and recursion cutoff D stored for that key and the current thread
+ * count in the per-host tuning file, or finds them with short timed trials
+ * and stores them there.
+ *
+ * The tuning file is $FW_TUNE_FILE, or ~/.fw_tune-<hostname>; one line per
+ * result, "key threads B D", the last matching line wins.
+ */
+#ifndef TUNE_H
+#define TUNE_H
+
+#define TUNE_MAX	16
+
+/* Seconds per cell update of a short run with block size B and cutoff D */
+typedef double (*tune_trial)(int B, int D);
+
+void tune_caches(long cache[3]);
+int tune_block_sizes(int *Bs);
+int tune_divisor(int n, int B);
+void tune_get(const char *key, int force, const int *Bs, int nB, const int *Ds, int nD,
+	      tune_trial trial, int *B, int *D);
+
+#endif
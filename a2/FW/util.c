@@ -4,15 +4,79 @@
 #include <sys/time.h>
 #include "util.h"
 
-void graph_init_random(int **adjm, int seed, int n,  int m)
+static inline int random_weight(void)
+{
+	return abs((( int)lrand48()) % 1048576);
+}
+
+void graph_init_random(struct matrix *adjm, int seed, int n,  int m)
 {
 	unsigned  int i, j;
 
 	srand48(seed);
 	for(i=0; i<n; i++)
 		for(j=0; j<n; j++)
-			adjm[i][j] = abs((( int)lrand48()) % 1048576);
+			*matrix_at(adjm,i,j) = random_weight();
 
-	for(i=0; i<n; i++)adjm[i][i]=0;
+	for(i=0; i<n; i++)*matrix_at(adjm,i,i)=0;
 }
 
+
+/*
+ * m random directed edges (no loops) with the same weights as above,
+ * INF everywhere else. Repeated edges keep the smaller weight.
+ */
+void graph_init_sparse(struct matrix *adjm, int seed, int n,  int m)
+{
+	unsigned  int i, j;
+	int e, w;
+
+	for(i=0; i<n; i++)
+		for(j=0; j<n; j++)
+			*matrix_at(adjm,i,j) = INF;
+	for(i=0; i<n; i++)*matrix_at(adjm,i,i)=0;
+
+	srand48(seed);
+	for(e=0; e<m && n>1; e++){
+		do {
+			i = lrand48() % n;
+			j = lrand48() % n;
+		} while(i==j);
+		w = random_weight();
+		if(w < *matrix_at(adjm,i,j))
+			*matrix_at(adjm,i,j) = w;
+	}
+}
+
+/*
+ * The graph every program starts from: dense, or with FW_DEGREE=d in the
+ * environment sparse with d*n random edges. Returns the number of edges
+ * generated.
+ */
+int graph_init(struct matrix *adjm, int seed, int n)
+{
+	char *degree=getenv("FW_DEGREE");
+
+	if(degree){
+		graph_init_sparse(adjm,seed,n,atoi(degree)*n);
+		return atoi(degree)*n;
+	}
+	graph_init_random(adjm,seed,n,128*n);
+	return n*(n-1);
+}
+
+/*
+ * Rows i0..i0+rows-1 of graph_init_random's matrix, row-major into band,
+ * for graphs too big to hold at once. The values continue the lrand48
+ * stream: call srand48(seed) first and then ask for the bands in order.
+ */
+void graph_random_band(int *band, int i0, int rows, int n)
+{
+	int i, j;
+
+	for(i=0; i<rows; i++){
+		for(j=0; j<n; j++)
+			band[(size_t)i*n+j] = random_weight();
+		band[(size_t)i*n+i0+i] = 0;
+	}
+}
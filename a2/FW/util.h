@@ -1,3 +1,10 @@
-//inline int min(int a, int b);
-void graph_init_random(int **adjm, int seed, int n,  int m);
+#include "matrix.h"
+
+/* Missing edge; INF+INF still fits in an int, so min-plus updates need no checks */
+#define INF 0x3fffffff
 
+//inline int min(int a, int b);
+void graph_init_random(struct matrix *adjm, int seed, int n,  int m);
+void graph_init_sparse(struct matrix *adjm, int seed, int n,  int m);
+int graph_init(struct matrix *adjm, int seed, int n);
+void graph_random_band(int *band, int i0, int rows, int n);